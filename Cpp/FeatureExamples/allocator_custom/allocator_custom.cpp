@@ -9,8 +9,14 @@
 #include <memory>
 #include <string>
 #include <list>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
 
 #include "../../helpers.h"
+#include "../../benchmark.h"
 
 namespace custom1
 {
@@ -87,9 +93,222 @@ namespace custom1
 	}
 }
 
+namespace custom2
+{
+	// bump-pointer 영역 할당기 (arena / monotonic allocator)
+	// - 할당은 현재 chunk 의 포인터를 정렬하고 앞으로 미는 것뿐. 개별 해제는 하지 않는다.
+	// - chunk 가 차면 두 배 크기의 chunk 를 뒤에 붙인다.
+	// - Reset() 은 첫 chunk 로 되돌리기만 하므로 O(1). chunk 는 그대로 두었다가 다음 프레임에 다시 쓴다.
+	//   (한 프레임에 쓰는 양이 비슷하면 두 번째 프레임부터 heap 할당이 없다)
+	// - 소멸자를 부르지 않으므로 Reset 전에 컨테이너를 먼저 파괴해야 한다.
+	// - 쓰레드 안전하지 않음. (쓰레드 / 프레임마다 하나씩)
+	class Arena
+	{
+	public:
+		explicit Arena(size_t initialChunkSize = 64 * 1024)
+		{
+			m_head = m_current = NewChunk(initialChunkSize);
+			SetCurrent(m_head);
+		}
+
+		~Arena()
+		{
+			Chunk* chunk = m_head;
+			while (chunk) {
+				Chunk* next = chunk->next;
+				::operator delete(chunk);
+				chunk = next;
+			}
+		}
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment)
+		{
+			const uintptr_t aligned = (m_cursor + alignment - 1) & ~(alignment - 1);
+			if (aligned > m_end || size > m_end - aligned)
+				return AllocateSlow(size, alignment);
+			m_cursor = aligned + size;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		// 지금까지 할당한 것을 모두 버린다. (chunk 는 보관)
+		void Reset() { SetCurrent(m_head); }
+
+		size_t Capacity() const { return m_capacity; }
+		size_t NumChunks() const { return m_numChunks; }
+
+	private:
+		// 헤더 바로 뒤가 데이터 영역.
+		struct alignas(std::max_align_t) Chunk
+		{
+			Chunk* next;
+			size_t size;
+
+			uintptr_t Begin() { return reinterpret_cast<uintptr_t>(this + 1); }
+		};
+
+		Chunk* NewChunk(size_t size)
+		{
+			Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+			chunk->next = nullptr;
+			chunk->size = size;
+			m_capacity += size;
+			++m_numChunks;
+			return chunk;
+		}
+
+		void SetCurrent(Chunk* chunk)
+		{
+			m_current = chunk;
+			m_cursor = chunk->Begin();
+			m_end = m_cursor + chunk->size;
+		}
+
+		// 현재 chunk 에 자리가 없을 때: Reset 전에 만들어 둔 다음 chunk 를 쓰거나, 새 chunk 를 붙인다.
+		void* AllocateSlow(size_t size, size_t alignment)
+		{
+			while (m_current->next) {
+				SetCurrent(m_current->next);
+				const uintptr_t aligned = (m_cursor + alignment - 1) & ~(alignment - 1);
+				if (aligned <= m_end && size <= m_end - aligned) {
+					m_cursor = aligned + size;
+					return reinterpret_cast<void*>(aligned);
+				}
+			}
+			const size_t needed = size + alignment;
+			const size_t doubled = m_current->size * 2;
+			Chunk* chunk = NewChunk(needed > doubled ? needed : doubled);
+			m_current->next = chunk;
+			SetCurrent(chunk);
+			const uintptr_t aligned = (m_cursor + alignment - 1) & ~(alignment - 1);
+			m_cursor = aligned + size;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		Chunk* m_head{ nullptr };
+		Chunk* m_current{ nullptr };
+		uintptr_t m_cursor{ 0 };
+		uintptr_t m_end{ 0 };
+		size_t m_capacity{ 0 };
+		size_t m_numChunks{ 0 };
+	};
+
+	// Arena 를 쓰는 표준 allocator. (custom1::allocator 와 같은 인터페이스)
+	// - deallocate 는 아무것도 하지 않는다. (vector 가 커지며 버린 버퍼도 Reset 까지 남음)
+	// - 같은 Arena 를 가리키면 같은 allocator.
+	template <typename T>
+	struct allocator
+	{
+		using value_type = T;
+
+		explicit allocator(Arena& arena) noexcept : arena(&arena) {}
+
+		template <typename U>
+		allocator(const allocator<U>& other) noexcept : arena(other.arena) {}
+
+		T* allocate(std::size_t n)
+		{
+			if (n > static_cast<std::size_t>(-1) / sizeof(T)) { throw std::bad_array_new_length(); }
+			return static_cast<T*>(arena->Allocate(sizeof(T) * n, alignof(T)));
+		}
+
+		void deallocate(T*, std::size_t) noexcept {}
+
+		template <typename U>
+		bool operator==(const allocator<U>& other) const noexcept { return arena == other.arena; }
+
+		Arena* arena;
+	};
+
+	void test()
+	{
+		helpers::PrintRepeatedChar('-', 50);
+		std::cout << __FUNCTION__ << std::endl;
+
+		Arena arena(1024);
+		for (int frame = 0; frame < 3; ++frame) {
+			{
+				std::vector<int, custom2::allocator<int>> vec{ custom2::allocator<int>(arena) };
+				std::list<std::string, custom2::allocator<std::string>> list{ custom2::allocator<std::string>(arena) };
+				for (int i = 0; i < 100; ++i) {
+					vec.push_back(i);
+					list.push_back(std::format("frame {} item {}", frame, i));
+				}
+				std::cout << std::format("frame {}: vec.size: {}, list.back: {}, arena chunks: {}, capacity: {} bytes\n",
+					frame, vec.size(), list.back(), arena.NumChunks(), arena.Capacity());
+			} // 컨테이너 먼저 파괴 (std::string 소멸자)
+			arena.Reset();
+		}
+	}
+}
+
+// 프레임마다 1M 노드 std::list 를 만들고 버리는 비용.
+// - std::allocator: 노드마다 new / delete.
+// - custom2::Arena: 노드마다 포인터 증가, 프레임 끝에 Reset. (list 소멸자는 여전히 노드를 순회)
+// - std::pmr::monotonic_buffer_resource: 같은 방식의 표준 구현. 첫 프레임의 크기로 버퍼를 잡아 release() 가 버퍼로 돌아가게 한다.
+namespace bench_arena
+{
+	constexpr int numNodes = 1'000'000;
+
+	template <typename List>
+	uint64_t BuildFrame(List& list)
+	{
+		for (int i = 0; i < numNodes; ++i)
+			list.push_back(i);
+		uint64_t sum = 0;
+		for (int value : list) sum += value;
+		return sum;
+	}
+
+	void Run()
+	{
+		helpers::PrintRepeatedChar('-', 50);
+		std::cout << __FUNCTION__ << std::endl;
+
+		uint64_t sink = 0;
+		benchmark::Options options;
+		options.maxRuns = 20;
+
+		auto base = benchmark::Run("list/std::allocator", [&]() {
+			std::list<int> list;
+			sink += BuildFrame(list);
+		}, options);
+		benchmark::Print(base);
+
+		custom2::Arena arena;
+		auto arenaResult = benchmark::Run("list/arena", [&]() {
+			{
+				std::list<int, custom2::allocator<int>> list{ custom2::allocator<int>(arena) };
+				sink += BuildFrame(list);
+			}
+			arena.Reset();
+		}, options);
+		benchmark::Print(arenaResult);
+		std::cout << std::format("  arena chunks: {}, capacity: {:.1f} MB\n", arena.NumChunks(), arena.Capacity() / 1e6);
+
+		std::vector<std::byte> buffer(arena.Capacity());
+		std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+		auto pmrResult = benchmark::Run("list/pmr::monotonic", [&]() {
+			{
+				std::pmr::list<int> list(&resource);
+				sink += BuildFrame(list);
+			}
+			resource.release();
+		}, options);
+		benchmark::Print(pmrResult);
+
+		std::cout << std::format("speedup vs std::allocator: arena {:.2f}x, pmr {:.2f}x (sink: {})\n",
+			base.medianSec / arenaResult.medianSec, base.medianSec / pmrResult.medianSec, sink);
+	}
+}
+
 int main()
 {
 	custom1::test();
+	custom2::test();
+	bench_arena::Run();
 
 	return 0;
 }
\ No newline at end of file
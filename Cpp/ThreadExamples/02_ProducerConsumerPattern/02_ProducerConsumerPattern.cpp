@@ -154,6 +154,416 @@ namespace test2_cv
 	}
 }
 
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include "MPMCQueue.h"
+#include "../06_ThreadPool/FutexLock.h"
+namespace test3_mpmc
+{
+	// test2_cv 와 같은 시나리오를 lock-free MPMC queue 로.
+	// - 비어 있으면 sleep 하며 polling(test1) 하거나 condition_variable 을 쓰지 않고 Pop() 에서 잠든다.
+	void producer(MPMCQueue<std::string>& downloaded_pages, int index)
+	{
+		for (int i = 0; i < 5; i++)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100 * index));
+			std::string content = std::format("data : {} : from thread({})", i, index);
+			std::cout << std::format("{}\n", content);
+
+			downloaded_pages.Push(std::move(content));
+		}
+	}
+
+	void consumer(MPMCQueue<std::string>& downloaded_pages)
+	{
+		while (true)
+		{
+			std::string content = downloaded_pages.Pop();
+			if (content.empty()) // 종료 신호
+				return;
+
+			std::cout << std::format("{} processed.\n", content);
+			std::this_thread::sleep_for(std::chrono::milliseconds(80));
+		}
+	}
+
+	void test()
+	{
+		std::cout << __func__ << std::endl;
+
+		MPMCQueue<std::string> downloaded_pages(64);
+
+		std::vector<std::thread> producers;
+		for (int i = 0; i < 5; i++) {
+			producers.push_back(std::thread(producer, std::ref(downloaded_pages), i + 1));
+		}
+
+		std::vector<std::thread> consumers;
+		for (int i = 0; i < 3; i++) {
+			consumers.push_back(std::thread(consumer, std::ref(downloaded_pages)));
+		}
+
+		for (int i = 0; i < 5; i++) { producers[i].join(); }
+		for (int i = 0; i < 3; i++) { downloaded_pages.Push(std::string()); }
+		for (int i = 0; i < 3; i++) { consumers[i].join(); }
+	}
+}
+
+// 5 producer / 3 consumer 로 수백만 개를 넘기며 처리량과 전달 지연(p50/p99) 측정.
+namespace bench_mpmc
+{
+	using clock = std::chrono::steady_clock;
+
+	struct Page
+	{
+		std::string content; // 짧은 문자열 (SSO, heap 할당 없음)
+		clock::time_point enqueued;
+		bool last{ false };
+	};
+
+	// 비교 대상: test2_cv 와 같은 mutex + condition_variable + std::queue
+	template <typename T>
+	class LockedQueue
+	{
+	public:
+		void Push(T&& item)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_queue.push(std::move(item));
+			}
+			m_cv.notify_one();
+		}
+
+		T Pop()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [this]() { return !m_queue.empty(); });
+			T item = std::move(m_queue.front());
+			m_queue.pop();
+			return item;
+		}
+
+	private:
+		std::queue<T> m_queue;
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+	};
+
+	// LockedQueue 의 std::mutex / condition_variable 을 FutexMutex / AutoResetEvent 로 바꾼 것.
+	// event 는 신호가 하나로 합쳐지므로, 꺼낸 뒤에도 남아 있으면 다시 Set() 해서 다음 consumer 를 깨운다.
+	template <typename T>
+	class FutexQueue
+	{
+	public:
+		void Push(T&& item)
+		{
+			{
+				std::lock_guard<ThreadPool::FutexMutex> lock(m_mutex);
+				m_queue.push(std::move(item));
+			}
+			m_notEmpty.Set();
+		}
+
+		T Pop()
+		{
+			while (true) {
+				std::optional<T> item;
+				bool more = false;
+				{
+					std::lock_guard<ThreadPool::FutexMutex> lock(m_mutex);
+					if (!m_queue.empty()) {
+						item.emplace(std::move(m_queue.front()));
+						m_queue.pop();
+						more = !m_queue.empty();
+					}
+				}
+				if (item) {
+					if (more)
+						m_notEmpty.Set();
+					return std::move(*item);
+				}
+				m_notEmpty.Wait();
+			}
+		}
+
+		ThreadPool::LockStats MutexStats() const { return m_mutex.Stats(); }
+		ThreadPool::LockStats EventStats() const { return m_notEmpty.Stats(); }
+
+	private:
+		std::queue<T> m_queue;
+		ThreadPool::FutexMutex m_mutex{ "FutexQueue.mutex" };
+		ThreadPool::AutoResetEvent m_notEmpty{ "FutexQueue.notEmpty" };
+	};
+
+	void PrintLockStats(const ThreadPool::LockStats& stats)
+	{
+		std::cout << std::format("  {:<20} acquisitions: {:>8}, contended: {:>8} ({:5.2f}%), wait: {:.1f} ms\n",
+			stats.name, stats.acquisitions, stats.contended, stats.ContendedRatio() * 100,
+			std::chrono::duration<double, std::milli>(stats.waitTime).count());
+	}
+
+	template <typename Queue>
+	void Run(const char* name, Queue& queue)
+	{
+		constexpr int numProducers = 5;
+		constexpr int numConsumers = 3;
+		constexpr int itemsPerProducer = 1'000'000;
+
+		std::vector<std::vector<int64_t>> latencies(numConsumers);
+		for (auto& l : latencies) l.reserve(numProducers * itemsPerProducer);
+
+		auto stp = clock::now();
+		std::vector<std::thread> producers;
+		for (int p = 0; p < numProducers; ++p) {
+			producers.emplace_back([&queue, p]() {
+				for (int i = 0; i < itemsPerProducer; ++i) {
+					queue.Push(Page{ std::to_string(i % 1000), clock::now() });
+				}
+			});
+		}
+		std::vector<std::thread> consumers;
+		for (int c = 0; c < numConsumers; ++c) {
+			consumers.emplace_back([&queue, &latency = latencies[c]]() {
+				while (true) {
+					Page page = queue.Pop();
+					if (page.last)
+						return;
+					latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+						clock::now() - page.enqueued).count());
+				}
+			});
+		}
+
+		for (auto& t : producers) t.join();
+		for (int c = 0; c < numConsumers; ++c) queue.Push(Page{ {}, {}, true });
+		for (auto& t : consumers) t.join();
+		const double elapsed = std::chrono::duration<double>(clock::now() - stp).count();
+
+		std::vector<int64_t> all;
+		for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+		auto percentile = [&all](double p) {
+			auto it = all.begin() + static_cast<size_t>(p * (all.size() - 1));
+			std::nth_element(all.begin(), it, all.end());
+			return *it;
+		};
+		const int64_t p50 = percentile(0.50);
+		const int64_t p99 = percentile(0.99);
+		std::cout << std::format("{:<14} items: {}, {:.2f} M items/s, p50: {} ns, p99: {} ns\n",
+			name, all.size(), all.size() / elapsed / 1e6, p50, p99);
+	}
+
+	void test()
+	{
+		std::cout << __func__ << std::endl;
+		{
+			LockedQueue<Page> queue;
+			Run("mutex+cv", queue);
+		}
+		{
+			FutexQueue<Page> queue;
+			Run("futex+event", queue);
+			PrintLockStats(queue.MutexStats());
+			PrintLockStats(queue.EventStats());
+		}
+		{
+			MPMCQueue<Page> queue(1024);
+			Run("mpmc(1024)", queue);
+		}
+	}
+}
+
+#include <array>
+#include <cstdint>
+#include "SPSCQueue.h"
+// producer 1 / consumer 1 에서 64 byte 메시지 1억 개를 넘기는 처리량 비교.
+namespace bench_spsc
+{
+	using clock = std::chrono::steady_clock;
+
+	struct alignas(64) Message
+	{
+		uint64_t sequence;
+		uint64_t payload[7];
+	};
+	static_assert(sizeof(Message) == 64);
+
+	constexpr uint64_t numMessages = 100'000'000;
+	constexpr size_t batchSize = 64;
+
+	void Report(const char* name, clock::time_point stp, uint64_t checksum, bool ordered)
+	{
+		const double elapsed = std::chrono::duration<double>(clock::now() - stp).count();
+		std::cout << std::format("{:<16} {:.2f} M msg/s, {:.2f} GB/s, {:.2f} s, checksum: {}, ordered: {}\n",
+			name, numMessages / elapsed / 1e6, numMessages * sizeof(Message) / elapsed / 1e9,
+			elapsed, checksum, ordered);
+	}
+
+	// test2_cv 와 같은 mutex + condition_variable 방식
+	void RunCondVar()
+	{
+		bench_mpmc::LockedQueue<Message> queue;
+		auto stp = clock::now();
+		std::thread producer([&queue]() {
+			for (uint64_t i = 0; i < numMessages; ++i)
+				queue.Push(Message{ i, { i } });
+		});
+
+		uint64_t checksum = 0;
+		bool ordered = true;
+		for (uint64_t i = 0; i < numMessages; ++i) {
+			Message msg = queue.Pop();
+			ordered &= (msg.sequence == i);
+			checksum += msg.payload[0];
+		}
+		producer.join();
+		Report("mutex+cv", stp, checksum, ordered);
+	}
+
+	void RunSPSC()
+	{
+		SPSCQueue<Message> queue(4096);
+		auto stp = clock::now();
+		std::thread producer([&queue]() {
+			for (uint64_t i = 0; i < numMessages; ++i) {
+				while (!queue.TryPush(Message{ i, { i } }))
+					std::this_thread::yield();
+			}
+		});
+
+		uint64_t checksum = 0;
+		bool ordered = true;
+		Message msg;
+		for (uint64_t i = 0; i < numMessages; ++i) {
+			while (!queue.TryPop(msg))
+				std::this_thread::yield();
+			ordered &= (msg.sequence == i);
+			checksum += msg.payload[0];
+		}
+		producer.join();
+		Report("spsc", stp, checksum, ordered);
+	}
+
+	void RunSPSCBatch()
+	{
+		SPSCQueue<Message> queue(4096);
+		auto stp = clock::now();
+		std::thread producer([&queue]() {
+			std::array<Message, batchSize> batch;
+			for (uint64_t i = 0; i < numMessages; i += batchSize) {
+				const size_t count = static_cast<size_t>(std::min<uint64_t>(batchSize, numMessages - i));
+				for (size_t k = 0; k < count; ++k)
+					batch[k] = Message{ i + k, { i + k } };
+
+				size_t pushed = 0;
+				while (pushed < count) {
+					const size_t n = queue.TryPushN(batch.begin() + pushed, count - pushed);
+					if (n == 0) std::this_thread::yield();
+					pushed += n;
+				}
+			}
+		});
+
+		uint64_t checksum = 0;
+		bool ordered = true;
+		std::array<Message, batchSize> batch;
+		for (uint64_t i = 0; i < numMessages;) {
+			const size_t n = queue.TryPopN(batch.begin(), batchSize);
+			if (n == 0) {
+				std::this_thread::yield();
+				continue;
+			}
+			for (size_t k = 0; k < n; ++k, ++i) {
+				ordered &= (batch[k].sequence == i);
+				checksum += batch[k].payload[0];
+			}
+		}
+		producer.join();
+		Report("spsc(batch 64)", stp, checksum, ordered);
+	}
+
+	void test()
+	{
+		std::cout << __func__ << std::endl;
+		RunCondVar();
+		RunSPSC();
+		RunSPSCBatch();
+	}
+}
+
+#include "PipelineStage.h"
+// test2_cv 는 producer 를 막지 않아 consumer 가 느리면 queue 가 끝없이 자란다.
+// PipelineStage 로 watermark(Block/Drop) 와 batch 꺼내기를 적용하고 통계를 출력한다.
+namespace test4_pipeline
+{
+	// consumer 쪽 처리 비용 흉내 (producer 보다 느리게)
+	uint64_t Process(uint64_t value)
+	{
+		for (int i = 0; i < 200; ++i)
+			value = value * 6364136223846793005ull + 1442695040888963407ull;
+		return value;
+	}
+
+	void Run(const char* name, const PipelineStageOptions& options)
+	{
+		constexpr int numProducers = 5;
+		constexpr int numConsumers = 3;
+		constexpr int itemsPerProducer = 200'000;
+
+		PipelineStage<uint64_t> stage(options);
+		std::atomic<uint64_t> checksum{ 0 };
+
+		auto stp = std::chrono::steady_clock::now();
+		std::vector<std::thread> producers;
+		for (int p = 0; p < numProducers; ++p) {
+			producers.emplace_back([&stage, p]() {
+				for (int i = 0; i < itemsPerProducer; ++i)
+					stage.Push(static_cast<uint64_t>(p) * itemsPerProducer + i);
+			});
+		}
+		std::vector<std::thread> consumers;
+		for (int c = 0; c < numConsumers; ++c) {
+			consumers.emplace_back([&stage, &checksum]() {
+				std::vector<uint64_t> batch;
+				batch.reserve(stage.Options().maxBatch);
+				uint64_t sum = 0;
+				while (stage.PopBatch(batch) > 0) {
+					// lock 밖에서 처리
+					for (uint64_t value : batch)
+						sum += Process(value);
+					batch.clear();
+				}
+				checksum += sum;
+			});
+		}
+
+		for (auto& t : producers) t.join();
+		stage.Close();
+		for (auto& t : consumers) t.join();
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - stp).count();
+
+		const PipelineStageStats stats = stage.Stats();
+		std::cout << std::format("[{}] high: {}, low: {}, maxBatch: {}, {:.3f} sec\n",
+			name, options.highWatermark, options.lowWatermark, options.maxBatch, elapsed);
+		std::cout << std::format("  pushed: {}, dropped: {}, stalls: {}, lock(pop): {}\n",
+			stats.pushed, stats.dropped, stats.stalls, stats.batchSize.Count());
+		std::cout << std::format("  queue depth  - {}\n", stats.queueDepth.ToString());
+		std::cout << std::format("  stall (ns)   - {}\n", stats.stallNs.ToString());
+		std::cout << std::format("  batch size   - {}\n", stats.batchSize.ToString());
+	}
+
+	void test()
+	{
+		std::cout << __func__ << std::endl;
+		// 사실상 제한 없음 (test2_cv 와 같은 동작), 한 개씩 꺼냄
+		Run("unbounded", { SIZE_MAX, SIZE_MAX - 1, OverflowPolicy::Block, 1 });
+		Run("block", { 1024, 512, OverflowPolicy::Block, 1 });
+		Run("block+batch", { 1024, 512, OverflowPolicy::Block, 32 });
+		Run("drop+batch", { 1024, 512, OverflowPolicy::Drop, 32 });
+	}
+}
+
 int main()
 {
 	auto PrintSplitLines = []() {std::cout << std::format("{:-<{}}\n", "", 50); };
@@ -163,4 +573,16 @@ int main()
 
 	PrintSplitLines();
 	test2_cv::test();
+
+	PrintSplitLines();
+	test3_mpmc::test();
+
+	PrintSplitLines();
+	bench_mpmc::test();
+
+	PrintSplitLines();
+	bench_spsc::test();
+
+	PrintSplitLines();
+	test4_pipeline::test();
 }
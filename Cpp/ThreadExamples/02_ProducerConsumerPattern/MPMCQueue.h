@@ -0,0 +1,203 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// 크기가 정해진 lock-free MPMC(multi-producer multi-consumer) ring buffer.
+// - Dmitry Vyukov 의 bounded MPMC queue 방식: slot 마다 sequence 번호를 두고,
+//   sequence 가 내 차례인지 보고 쓰기/읽기를 결정한다.
+// - head/tail 과 각 slot 은 cache-line 단위로 떨어뜨려 false sharing 을 막는다.
+// - TryPush/TryPop 은 막히지 않고, Push/Pop 은 자리가 날 때까지
+//   잠깐 spin 후 C++20 std::atomic::wait/notify 로 잠든다. (mutex/condition_variable 없음)
+// - 선점한 slot 은 반드시 채워서 넘겨야 뒤의 차례가 막히지 않는다.
+//   그래서 예외를 던질 수 있는 생성(복사 등) 은 선점 전에 해 두고, slot 에는 예외 없이 옮기기만 한다.
+template <typename T>
+class MPMCQueue
+{
+	static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>,
+		"MPMCQueue: T 는 예외 없이 move 할 수 있어야 함");
+
+public:
+	explicit MPMCQueue(size_t capacity)
+	{
+		if (capacity == 0) {
+			throw std::invalid_argument("MPMCQueue: capacity 는 0 보다 커야 함");
+		}
+		m_capacity = 1;
+		while (m_capacity < capacity) m_capacity <<= 1; // 2의 거듭제곱으로 올림
+		m_mask = m_capacity - 1;
+
+		m_slots = std::make_unique<Slot[]>(m_capacity);
+		for (size_t i = 0; i < m_capacity; ++i) {
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~MPMCQueue()
+	{
+		// 남아 있는 원소 파괴
+		T item;
+		while (TryPop(item)) {}
+	}
+
+	MPMCQueue(const MPMCQueue&) = delete;
+	MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+	size_t Capacity() const { return m_capacity; }
+
+	// 가득 차서 실패하면 미리 만든 값은 버려진다. (TryPush(T&&) 는 넘긴 값을 건드리지 않음)
+	template <typename... Args>
+	bool TryEmplace(Args&&... args)
+	{
+		if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+			size_t pos = m_enqueuePos.value.load(std::memory_order_relaxed);
+			while (true) {
+				Slot& slot = m_slots[pos & m_mask];
+				const size_t seq = slot.sequence.load(std::memory_order_acquire);
+				const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0) {
+					// 비어 있는 내 차례 slot: pos 를 선점.
+					if (m_enqueuePos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						Write(slot, pos, std::forward<Args>(args)...);
+						return true;
+					}
+				}
+				else if (diff < 0) {
+					return false; // 가득 참
+				}
+				else {
+					pos = m_enqueuePos.value.load(std::memory_order_relaxed);
+				}
+			}
+		}
+		else {
+			return TryEmplace(T(std::forward<Args>(args)...));
+		}
+	}
+
+	bool TryPush(T&& item) { return TryEmplace(std::move(item)); }
+	bool TryPush(const T& item) { return TryEmplace(item); }
+
+	bool TryPop(T& item)
+	{
+		size_t pos = m_dequeuePos.value.load(std::memory_order_relaxed);
+		while (true) {
+			Slot& slot = m_slots[pos & m_mask];
+			const size_t seq = slot.sequence.load(std::memory_order_acquire);
+			const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+			if (diff == 0) {
+				if (m_dequeuePos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					Read(slot, pos, item);
+					return true;
+				}
+			}
+			else if (diff < 0) {
+				return false; // 비어 있음
+			}
+			else {
+				pos = m_dequeuePos.value.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// 자리가 날 때까지 기다린다.
+	// 번호표(pos) 를 먼저 받고 해당 slot 의 차례를 기다리므로 도착 순서대로 처리된다.
+	template <typename... Args>
+	void Emplace(Args&&... args)
+	{
+		if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+			const size_t pos = m_enqueuePos.value.fetch_add(1, std::memory_order_relaxed);
+			Slot& slot = m_slots[pos & m_mask];
+			WaitForSequence(slot, pos);
+			Write(slot, pos, std::forward<Args>(args)...);
+		}
+		else {
+			Emplace(T(std::forward<Args>(args)...));
+		}
+	}
+
+	void Push(T&& item) { Emplace(std::move(item)); }
+	void Push(const T& item) { Emplace(item); }
+
+	T Pop()
+	{
+		T item; // 선점 전에 만든다. (기본 생성자가 던져도 slot 은 그대로)
+		const size_t pos = m_dequeuePos.value.fetch_add(1, std::memory_order_relaxed);
+		Slot& slot = m_slots[pos & m_mask];
+		WaitForSequence(slot, pos + 1);
+		Read(slot, pos, item);
+		return item;
+	}
+
+private:
+	struct alignas(std::hardware_destructive_interference_size) Slot
+	{
+		std::atomic<size_t> sequence;
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		T* Get() { return std::launder(reinterpret_cast<T*>(storage)); }
+	};
+
+	struct alignas(std::hardware_destructive_interference_size) PaddedPos
+	{
+		std::atomic<size_t> value{ 0 };
+	};
+
+	template <typename... Args>
+	void Write(Slot& slot, size_t pos, Args&&... args) noexcept
+	{
+		::new (static_cast<void*>(slot.storage)) T(std::forward<Args>(args)...);
+		Publish(slot, pos + 1);
+	}
+
+	void Read(Slot& slot, size_t pos, T& item) noexcept
+	{
+		item = std::move(*slot.Get());
+		slot.Get()->~T();
+		Publish(slot, pos + m_capacity); // 한 바퀴 뒤의 producer 차례
+	}
+
+	void Publish(Slot& slot, size_t sequence)
+	{
+		slot.sequence.store(sequence, std::memory_order_seq_cst);
+		// 잠든 쓰레드가 없으면 notify 생략.
+		// (잠드는 쪽은 m_numWaiters 증가 후 sequence 를 다시 확인 - 둘 다 seq_cst)
+		if (m_numWaiters.value.load(std::memory_order_seq_cst) > 0)
+			slot.sequence.notify_all();
+	}
+
+	void WaitForSequence(Slot& slot, size_t expected)
+	{
+		for (int spin = 0; spin < kSpinCount; ++spin) {
+			if (slot.sequence.load(std::memory_order_acquire) == expected)
+				return;
+		}
+		while (true) {
+			size_t seq = slot.sequence.load(std::memory_order_acquire);
+			if (seq == expected)
+				return;
+			m_numWaiters.value.fetch_add(1, std::memory_order_seq_cst);
+			seq = slot.sequence.load(std::memory_order_seq_cst);
+			if (seq != expected)
+				slot.sequence.wait(seq, std::memory_order_acquire);
+			m_numWaiters.value.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	static constexpr int kSpinCount = 256;
+
+	size_t m_capacity{ 0 };
+	size_t m_mask{ 0 };
+	std::unique_ptr<Slot[]> m_slots;
+
+	PaddedPos m_enqueuePos; // tail
+	PaddedPos m_dequeuePos; // head
+	PaddedPos m_numWaiters;
+};
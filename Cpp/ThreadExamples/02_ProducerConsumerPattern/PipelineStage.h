@@ -0,0 +1,168 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../06_ThreadPool/Histogram.h"
+
+// 가득 찼을 때 producer 쪽 처리 방법
+enum class OverflowPolicy
+{
+	Block, // low watermark 까지 줄어들 때까지 기다린다.
+	Drop,  // 넣지 않고 버린다. (Push 가 false)
+};
+
+struct PipelineStageOptions
+{
+	size_t highWatermark{ 1024 };  // 이 개수에 도달하면 producer 를 막는다(또는 버린다).
+	size_t lowWatermark{ 512 };    // 막힌 뒤에는 이 개수 이하로 줄어야 다시 받는다.
+	OverflowPolicy policy{ OverflowPolicy::Block };
+	size_t maxBatch{ 32 };         // consumer 가 lock 한 번에 꺼낼 최대 개수
+};
+
+// 조정용 통계. Stats() 로 복사해 간다.
+struct PipelineStageStats
+{
+	uint64_t pushed{ 0 };
+	uint64_t dropped{ 0 };
+	uint64_t stalls{ 0 };        // Block 정책에서 producer 가 기다린 횟수
+	// lock 안에서 기록하므로 동기화하지 않는 histogram 을 쓴다.
+	ThreadPool::Histogram queueDepth; // Push 직후 queue 길이
+	ThreadPool::Histogram stallNs;    // producer 가 기다린 시간 (ns)
+	ThreadPool::Histogram batchSize;  // PopBatch 한 번에 꺼낸 개수
+};
+
+// mutex + condition_variable 기반 producer/consumer 사이의 한 단계.
+// - high/low watermark 로 queue 길이를 제한한다. (두 값 사이에서 막힘/풀림이 반복되지 않도록 hysteresis)
+// - consumer 는 PopBatch() 로 lock 한 번에 최대 maxBatch 개를 꺼내고, lock 밖에서 처리한다.
+// - Close() 후에는 Push 가 실패하고, 남은 것을 다 꺼내면 PopBatch 가 0 을 돌려준다.
+template <typename T>
+class PipelineStage
+{
+public:
+	explicit PipelineStage(const PipelineStageOptions& options = {}) : m_options(options)
+	{
+		if (m_options.highWatermark == 0 || m_options.lowWatermark >= m_options.highWatermark) {
+			throw std::invalid_argument("PipelineStage: lowWatermark < highWatermark 이어야 함");
+		}
+		if (m_options.maxBatch == 0) {
+			throw std::invalid_argument("PipelineStage: maxBatch 는 0 보다 커야 함");
+		}
+	}
+
+	PipelineStage(const PipelineStage&) = delete;
+	PipelineStage& operator=(const PipelineStage&) = delete;
+
+	// 넣었으면 true, 버려졌거나(Drop) 닫혔으면 false.
+	bool Push(T item)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_throttled && !m_closed) {
+			if (m_options.policy == OverflowPolicy::Drop) {
+				++m_stats.dropped;
+				return false;
+			}
+
+			const auto stp = std::chrono::steady_clock::now();
+			++m_numWaitingProducers;
+			m_cvNotFull.wait(lock, [this]() { return !m_throttled || m_closed; });
+			--m_numWaitingProducers;
+			++m_stats.stalls;
+			m_stats.stallNs.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - stp).count());
+		}
+		if (m_closed)
+			return false;
+
+		m_queue.push_back(std::move(item));
+		const size_t depth = m_queue.size();
+		if (depth >= m_options.highWatermark)
+			m_throttled = true;
+		++m_stats.pushed;
+		m_stats.queueDepth.Record(depth);
+
+		const bool wakeConsumer = m_numWaitingConsumers > 0;
+		lock.unlock();
+		if (wakeConsumer)
+			m_cvNotEmpty.notify_one();
+		return true;
+	}
+
+	// 최대 maxBatch 개를 out 뒤에 붙이고 개수를 돌려준다. 비어 있으면 기다린다.
+	// 0 이면 닫혔고 더 꺼낼 것이 없음.
+	size_t PopBatch(std::vector<T>& out)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		++m_numWaitingConsumers;
+		m_cvNotEmpty.wait(lock, [this]() { return !m_queue.empty() || m_closed; });
+		--m_numWaitingConsumers;
+
+		const size_t n = std::min(m_queue.size(), m_options.maxBatch);
+		for (size_t i = 0; i < n; ++i) {
+			out.push_back(std::move(m_queue.front()));
+			m_queue.pop_front();
+		}
+		if (n > 0)
+			m_stats.batchSize.Record(n);
+
+		bool wakeProducers = false;
+		if (m_throttled && m_queue.size() <= m_options.lowWatermark) {
+			m_throttled = false;
+			wakeProducers = m_numWaitingProducers > 0;
+		}
+		// 다 꺼내지 못했으면 다른 consumer 도 이어서 꺼내도록
+		const bool wakeConsumer = !m_queue.empty() && m_numWaitingConsumers > 0;
+		lock.unlock();
+		if (wakeProducers)
+			m_cvNotFull.notify_all();
+		if (wakeConsumer)
+			m_cvNotEmpty.notify_one();
+		return n;
+	}
+
+	void Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+		}
+		m_cvNotFull.notify_all();
+		m_cvNotEmpty.notify_all();
+	}
+
+	size_t Size() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue.size();
+	}
+
+	PipelineStageStats Stats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+	const PipelineStageOptions& Options() const { return m_options; }
+
+private:
+	const PipelineStageOptions m_options;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cvNotEmpty;
+	std::condition_variable m_cvNotFull;
+	std::deque<T> m_queue;
+	bool m_throttled{ false };
+	bool m_closed{ false };
+	size_t m_numWaitingProducers{ 0 };
+	size_t m_numWaitingConsumers{ 0 };
+
+	PipelineStageStats m_stats;
+};
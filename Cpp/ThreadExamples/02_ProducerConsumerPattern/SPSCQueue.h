@@ -0,0 +1,125 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// producer 1개, consumer 1개 전용 wait-free ring buffer.
+// - 용량은 2의 거듭제곱, index 는 계속 증가시키고 mask 로 slot 을 찾는다.
+// - producer 는 tail 만, consumer 는 head 만 쓴다. (CAS 없음)
+// - 상대 index 는 로컬에 cache 해 두고, 가득 참/비어 있음으로 보일 때만 다시 읽는다.
+//   (매번 상대 cache-line 을 읽어 오지 않음)
+// - TryPushN/TryPopN 은 여러 개를 한 번의 index 갱신으로 넘긴다.
+// T 는 기본 생성 + move 대입이 가능해야 한다.
+template <typename T>
+class SPSCQueue
+{
+public:
+	explicit SPSCQueue(size_t capacity)
+	{
+		if (capacity == 0) {
+			throw std::invalid_argument("SPSCQueue: capacity 는 0 보다 커야 함");
+		}
+		m_capacity = 1;
+		while (m_capacity < capacity) m_capacity <<= 1;
+		m_mask = m_capacity - 1;
+		m_buffer = std::make_unique<T[]>(m_capacity);
+	}
+
+	SPSCQueue(const SPSCQueue&) = delete;
+	SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+	size_t Capacity() const { return m_capacity; }
+
+	// producer 전용
+	template <typename U>
+	bool TryPush(U&& item)
+	{
+		const size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+		if (tail - m_producer.cachedHead == m_capacity) {
+			m_producer.cachedHead = m_consumer.head.load(std::memory_order_acquire);
+			if (tail - m_producer.cachedHead == m_capacity)
+				return false;
+		}
+		m_buffer[tail & m_mask] = std::forward<U>(item);
+		m_producer.tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// [first, first + count) 중 들어가는 만큼 넣고, 넣은 개수를 돌려준다.
+	template <typename InputIt>
+	size_t TryPushN(InputIt first, size_t count)
+	{
+		const size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+		size_t free = m_capacity - (tail - m_producer.cachedHead);
+		if (free < count) {
+			m_producer.cachedHead = m_consumer.head.load(std::memory_order_acquire);
+			free = m_capacity - (tail - m_producer.cachedHead);
+		}
+		const size_t n = std::min(free, count);
+		for (size_t i = 0; i < n; ++i, ++first) {
+			m_buffer[(tail + i) & m_mask] = *first;
+		}
+		if (n > 0)
+			m_producer.tail.store(tail + n, std::memory_order_release);
+		return n;
+	}
+
+	// consumer 전용
+	bool TryPop(T& item)
+	{
+		const size_t head = m_consumer.head.load(std::memory_order_relaxed);
+		if (head == m_consumer.cachedTail) {
+			m_consumer.cachedTail = m_producer.tail.load(std::memory_order_acquire);
+			if (head == m_consumer.cachedTail)
+				return false;
+		}
+		item = std::move(m_buffer[head & m_mask]);
+		m_consumer.head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// 최대 maxCount 개를 out 으로 꺼내고, 꺼낸 개수를 돌려준다.
+	template <typename OutputIt>
+	size_t TryPopN(OutputIt out, size_t maxCount)
+	{
+		const size_t head = m_consumer.head.load(std::memory_order_relaxed);
+		size_t available = m_consumer.cachedTail - head;
+		if (available < maxCount) {
+			m_consumer.cachedTail = m_producer.tail.load(std::memory_order_acquire);
+			available = m_consumer.cachedTail - head;
+		}
+		const size_t n = std::min(available, maxCount);
+		for (size_t i = 0; i < n; ++i, ++out) {
+			*out = std::move(m_buffer[(head + i) & m_mask]);
+		}
+		if (n > 0)
+			m_consumer.head.store(head + n, std::memory_order_release);
+		return n;
+	}
+
+private:
+	// producer / consumer 가 쓰는 값들을 서로 다른 cache-line 에 둔다.
+	struct alignas(std::hardware_destructive_interference_size) ProducerSide
+	{
+		std::atomic<size_t> tail{ 0 };
+		size_t cachedHead{ 0 };
+	};
+
+	struct alignas(std::hardware_destructive_interference_size) ConsumerSide
+	{
+		std::atomic<size_t> head{ 0 };
+		size_t cachedTail{ 0 };
+	};
+
+	size_t m_capacity{ 0 };
+	size_t m_mask{ 0 };
+	std::unique_ptr<T[]> m_buffer;
+
+	ProducerSide m_producer;
+	ConsumerSide m_consumer;
+};
@@ -3,6 +3,17 @@
 #include <atomic>
 #include <format>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <random>
+#include <cstdint>
+
+#include "Litmus.h"
+#include "SeqLock.h"
+#include "EpochReclamation.h"
+#include "HazardPointer.h"
 
 namespace test1
 {
@@ -144,8 +155,356 @@ namespace test3
 	}
 }
 
+// 위의 test1~3 은 반복마다 쓰레드를 만들기 때문에 쓰레드 생성 시간이 대부분이고,
+// 두 쓰레드가 실제로 겹쳐 실행되는 경우가 드물어 reordering 이 잘 보이지 않는다.
+// Litmus::Run 은 고정된 쓰레드들이 barrier 로 함께 출발해 1024 개 변수 묶음을 한 번에 실행한다.
+namespace litmus
+{
+	void Print(const Litmus::Result& result)
+	{
+		std::cout << std::format("{:<36} {:>6.1f} M/s, weak {:<22}: {:>8} ({:.4f}%)\n",
+			result.name, result.total / result.seconds / 1e6, result.outcomes[result.weakOutcome],
+			result.Weak(), 100.0 * result.Weak() / result.total);
+	}
+
+	void PrintHistogram(const Litmus::Result& result)
+	{
+		std::cout << std::format("{} ({} runs)\n", result.name, result.total);
+		for (size_t o = 0; o < result.counts.size(); ++o) {
+			if (result.counts[o] == 0)
+				continue;
+			std::cout << std::format("  {:<24} {:>10}{}\n", result.outcomes[o], result.counts[o],
+				o == result.weakOutcome ? "  <- weak" : "");
+		}
+	}
+
+	void Run()
+	{
+		using namespace Litmus;
+		constexpr auto relaxed = std::memory_order_relaxed;
+		constexpr auto acquire = std::memory_order_acquire;
+		constexpr auto release = std::memory_order_release;
+		constexpr auto seq_cst = std::memory_order_seq_cst;
+		constexpr size_t iterations = 2000; // x 1024 개
+
+		PrintHistogram(Litmus::Run<StoreBuffering<relaxed, relaxed>>(iterations));
+		PrintHistogram(Litmus::Run<IndependentReads<relaxed, relaxed>>(iterations / 2));
+
+		// 같은 test 를 memory_order 만 바꿔 비교.
+		Print(Litmus::Run<StoreBuffering<relaxed, relaxed>>(iterations));
+		Print(Litmus::Run<StoreBuffering<release, acquire>>(iterations));
+		Print(Litmus::Run<StoreBuffering<seq_cst, seq_cst>>(iterations));
+		Print(Litmus::Run<StoreBufferingFence<std::memory_order_acq_rel>>(iterations));
+		Print(Litmus::Run<StoreBufferingFence<seq_cst>>(iterations));
+
+		Print(Litmus::Run<MessagePassing<relaxed, relaxed>>(iterations));
+		Print(Litmus::Run<MessagePassing<release, acquire>>(iterations));
+
+		Print(Litmus::Run<LoadBuffering<relaxed, relaxed>>(iterations));
+		Print(Litmus::Run<LoadBuffering<acquire, release>>(iterations));
+
+		Print(Litmus::Run<IndependentReads<relaxed, relaxed>>(iterations / 2));
+		Print(Litmus::Run<IndependentReads<release, acquire>>(iterations / 2));
+		Print(Litmus::Run<IndependentReads<seq_cst, seq_cst>>(iterations / 2));
+	}
+}
+
+// test3 의 release/acquire 게시를 여러 reader 에 대해: 카메라 상태를 writer 하나가 계속 갱신하고 reader 들이 읽는다.
+// shared_mutex 는 읽기마다 lock 의 reader 수를 갱신하므로(같은 cache-line 에 쓰기) reader 가 늘수록 느려지고,
+// SeqLock 의 reader 는 읽기만 한다.
+namespace bench_seqlock
+{
+	struct Camera
+	{
+		uint64_t frame;
+		float position[3];
+		float direction[3];
+		float fov;
+		float check; // frame 에서 계산한 값 (찢어진 값이면 맞지 않음)
+	};
+
+	Camera MakeCamera(uint64_t frame)
+	{
+		const float f = static_cast<float>(frame);
+		return { frame, { f, f + 1, f + 2 }, { -f, -f - 1, -f - 2 }, 60.0f, f * 3.0f };
+	}
+
+	bool IsConsistent(const Camera& c)
+	{
+		const float f = static_cast<float>(c.frame);
+		return c.position[0] == f && c.direction[2] == -f - 2 && c.check == f * 3.0f;
+	}
+
+	class SharedMutexCamera
+	{
+	public:
+		Camera Load() const
+		{
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			return m_camera;
+		}
+		void Store(const Camera& camera)
+		{
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			m_camera = camera;
+		}
+
+	private:
+		mutable std::shared_mutex m_mutex;
+		Camera m_camera{};
+	};
+
+	// numReaders 개 reader 가 duration 동안 읽은 총 횟수 (M reads/s), writer 의 갱신 횟수, 찢어진 값의 수.
+	// reader 가 스스로 시간을 확인해서 멈춘다. (shared_mutex 는 reader 가 많으면 writer 가 lock 을 못 잡고 굶을 수 있음)
+	template <class Storage>
+	void Measure(const char* name, size_t numReaders, std::chrono::milliseconds duration)
+	{
+		using clock = std::chrono::steady_clock;
+		Storage storage;
+		storage.Store(MakeCamera(0));
+		std::atomic<uint64_t> totalReads{ 0 };
+		std::atomic<uint64_t> torn{ 0 };
+
+		const auto stp = clock::now();
+		const auto deadline = stp + duration;
+		std::vector<std::thread> readers;
+		for (size_t i = 0; i < numReaders; ++i) {
+			readers.emplace_back([&]() {
+				uint64_t reads = 0, bad = 0;
+				do {
+					for (int k = 0; k < 256; ++k) {
+						const Camera camera = storage.Load();
+						bad += !IsConsistent(camera);
+					}
+					reads += 256;
+				} while (clock::now() < deadline);
+				totalReads += reads;
+				torn += bad;
+			});
+		}
+
+		// writer: 약 10us 마다 갱신 (게임의 frame 보다 훨씬 자주)
+		uint64_t frame = 0;
+		while (clock::now() < deadline) {
+			storage.Store(MakeCamera(++frame));
+			const auto next = clock::now() + std::chrono::microseconds(10);
+			while (clock::now() < next) {}
+		}
+		for (auto& t : readers) t.join();
+		const double sec = std::chrono::duration<double>(clock::now() - stp).count();
+
+		std::cout << std::format("{:<12} readers {:>2}: {:>8.2f} M reads/s, writes: {:>6}, torn: {}\n",
+			name, numReaders, totalReads / sec / 1e6, frame, torn.load());
+	}
+
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
+		constexpr auto duration = std::chrono::milliseconds(200);
+		for (size_t numReaders : { 1, 2, 4, 8, 16, 32, 64 }) {
+			Measure<SeqLock<Camera>>("SeqLock", numReaders, duration);
+			Measure<SharedMutexCamera>("shared_mutex", numReaders, duration);
+		}
+	}
+}
+
+// 정렬된 lock-free 연결 리스트 (Harris-Michael) 로 EpochDomain / HazardDomain 비교.
+// 삭제는 next 의 하위 bit 로 표시(mark) 한 뒤 연결을 끊고, 끊은 쓰레드가 Retire 한다.
+namespace bench_reclamation
+{
+	template <typename Domain>
+	class LockFreeList
+	{
+		struct Node
+		{
+			int key;
+			std::atomic<Node*> next{ nullptr };
+		};
+
+		static bool IsMarked(Node* p) { return reinterpret_cast<uintptr_t>(p) & 1; }
+		static Node* Marked(Node* p) { return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(p) | 1); }
+		static Node* Unmarked(Node* p) { return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(1)); }
+
+		using Guard = typename Domain::Guard;
+
+		// key 이상인 첫 노드(cur) 와 그 앞의 링크(prev).
+		struct Position
+		{
+			std::atomic<Node*>* prev;
+			Node* cur;
+			Node* next;
+		};
+
+	public:
+		explicit LockFreeList(Domain& domain) : m_domain(domain) {}
+		~LockFreeList()
+		{
+			Node* node = m_head.load();
+			while (node) {
+				Node* next = Unmarked(node->next.load());
+				delete node;
+				node = next;
+			}
+		}
+
+		bool Contains(int key)
+		{
+			Guard guard = m_domain.Pin();
+			Position pos;
+			return Find(guard, key, pos);
+		}
+
+		bool Insert(int key)
+		{
+			Guard guard = m_domain.Pin();
+			Node* node = new Node{ key };
+			Position pos;
+			while (true) {
+				if (Find(guard, key, pos)) {
+					delete node;
+					return false;
+				}
+				node->next.store(pos.cur, std::memory_order_relaxed);
+				Node* expected = pos.cur;
+				if (pos.prev->compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed))
+					return true;
+			}
+		}
+
+		bool Remove(int key)
+		{
+			Guard guard = m_domain.Pin();
+			Position pos;
+			while (true) {
+				if (!Find(guard, key, pos))
+					return false;
+				// 1. 삭제 표시. (이후 cur 뒤에 끼워 넣거나 cur 를 다시 지우는 CAS 는 실패)
+				Node* next = pos.next;
+				if (!pos.cur->next.compare_exchange_strong(next, Marked(next), std::memory_order_acq_rel, std::memory_order_relaxed))
+					continue;
+				// 2. 연결 끊기. 실패하면 Find 가 지나가며 대신 끊는다.
+				Node* expected = pos.cur;
+				if (pos.prev->compare_exchange_strong(expected, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+					guard.Retire(pos.cur);
+				else
+					Find(guard, key, pos);
+				return true;
+			}
+		}
+
+	private:
+		// hazard slot 3 개를 prev 노드 / cur / next 로 돌려 쓴다.
+		bool Find(Guard& guard, int key, Position& pos)
+		{
+		retry:
+			size_t prevSlot = 2, curSlot = 1, nextSlot = 0;
+			std::atomic<Node*>* prev = &m_head;
+			Node* cur = guard.Protect(curSlot, *prev);
+			while (true) {
+				if (cur == nullptr) {
+					pos = { prev, nullptr, nullptr };
+					return false;
+				}
+				Node* next = guard.Protect(nextSlot, cur->next);
+				// next 를 읽는 동안 cur 가 prev 에서 떨어졌으면 next 를 믿을 수 없다.
+				if (prev->load(std::memory_order_acquire) != cur)
+					goto retry;
+
+				if (!IsMarked(next)) {
+					if (cur->key >= key) {
+						pos = { prev, cur, next };
+						return cur->key == key;
+					}
+					prev = &cur->next;
+					std::swap(prevSlot, curSlot); // cur 가 prev 노드가 된다.
+				}
+				else {
+					// 표시된 노드를 대신 끊는다.
+					Node* expected = cur;
+					if (!prev->compare_exchange_strong(expected, Unmarked(next), std::memory_order_acq_rel, std::memory_order_relaxed))
+						goto retry;
+					guard.Retire(cur);
+				}
+				std::swap(curSlot, nextSlot); // next 가 cur 가 된다.
+				cur = Unmarked(next);
+			}
+		}
+
+		Domain& m_domain;
+		std::atomic<Node*> m_head{ nullptr };
+	};
+
+	// 읽기 90%, 삽입 5%, 삭제 5%. key 범위의 절반 정도가 들어 있는 상태를 유지한다.
+	template <typename Domain>
+	void Measure(const char* name, size_t numThreads, std::chrono::milliseconds duration)
+	{
+		using clock = std::chrono::steady_clock;
+		constexpr int keyRange = 1024;
+
+		Domain domain;
+		size_t maxRetired = 0;
+		uint64_t totalOps = 0;
+		double sec = 0.0;
+		{
+			LockFreeList<Domain> list(domain);
+			for (int key = 0; key < keyRange; key += 2) list.Insert(key);
+
+			std::atomic<uint64_t> ops{ 0 };
+			std::atomic<size_t> peak{ 0 };
+			const auto stp = clock::now();
+			const auto deadline = stp + duration;
+			std::vector<std::thread> threads;
+			for (size_t t = 0; t < numThreads; ++t) {
+				threads.emplace_back([&, t]() {
+					std::mt19937 rng(static_cast<uint32_t>(t) + 1);
+					uint64_t count = 0;
+					do {
+						for (int k = 0; k < 256; ++k) {
+							const uint32_t r = rng();
+							const int key = static_cast<int>(r % keyRange);
+							const uint32_t op = (r >> 16) % 100;
+							if (op < 90) list.Contains(key);
+							else if (op < 95) list.Insert(key);
+							else list.Remove(key);
+						}
+						count += 256;
+						size_t retired = domain.NumRetired();
+						size_t seen = peak.load(std::memory_order_relaxed);
+						while (retired > seen && !peak.compare_exchange_weak(seen, retired)) {}
+					} while (clock::now() < deadline);
+					ops += count;
+				});
+			}
+			for (auto& t : threads) t.join();
+			sec = std::chrono::duration<double>(clock::now() - stp).count();
+			totalOps = ops;
+			maxRetired = peak;
+		}
+
+		std::cout << std::format("{:<14} threads {:>2}: {:>7.2f} M ops/s, peak retired (not freed): {:>6}\n",
+			name, numThreads, totalOps / sec / 1e6, maxRetired);
+	}
+
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
+		constexpr auto duration = std::chrono::milliseconds(200);
+		for (size_t numThreads : { 1, 2, 4, 8 }) {
+			Measure<EpochDomain>("epoch", numThreads, duration);
+			Measure<HazardDomain>("hazard pointer", numThreads, duration);
+		}
+	}
+}
+
 int main()
 {
+	// litmus 실행기로 본 결과.
+	litmus::Run();
+
+	bench_seqlock::Run();
+
+	bench_reclamation::Run();
+
 	// test1 은 자주 발생.
 	// test2, test3 번은 확인 하기 어려움.
 
@@ -0,0 +1,148 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "../07_FalseSharing/ShardedCounter.h"
+
+// lock-free 자료구조에서 떼어 낸 노드를 언제 delete 해도 되는지 정하는 방법 (1): epoch 기반 회수 (EBR)
+// - 노드를 읽는 구간은 Pin() 의 Guard 로 감싼다. 들어갈 때 전역 epoch 를 자기 slot 에 적고, 나올 때 지운다.
+//   (slot 은 PerThread 로 cache-line 마다 떨어져 있어 reader 끼리 충돌하지 않음)
+// - 떼어 낸 노드는 Retire 로 넘기면 그때의 epoch 와 함께 쓰레드별 목록에 쌓인다.
+// - 목록이 batchSize 만큼 차면 모든 활성 쓰레드가 현재 epoch 에 들어와 있는지 확인하고 epoch 를 올린다.
+//   epoch 가 2 이상 지난 노드는 이미 모든 reader 가 떠났으므로 한꺼번에 delete.
+// - reader 의 비용은 Guard 당 store + fence 하나. 대신 Guard 안에서 멈춘(오래 걸리는) 쓰레드가 있으면 epoch 가 못 올라가
+//   회수가 통째로 밀린다. (HazardPointer.h 는 이 경우에도 회수량에 상한이 있음)
+class EpochDomain
+{
+	static constexpr uint64_t kInactive = std::numeric_limits<uint64_t>::max();
+
+	struct Retired
+	{
+		void* pointer;
+		void (*deleter)(void*);
+		uint64_t epoch;
+	};
+
+	struct ThreadState
+	{
+		std::atomic<uint64_t> epoch{ kInactive }; // 다른 쓰레드가 읽음
+		uint32_t nesting{ 0 };
+		std::vector<Retired> retired;             // 이 slot 의 쓰레드만 사용
+	};
+
+public:
+	// numSlots: 동시에 살아 있는 쓰레드 수의 상한 (PerThread)
+	explicit EpochDomain(size_t numSlots = 128, size_t batchSize = 128)
+		: m_threads(numSlots), m_batchSize(batchSize) {}
+
+	// 모든 쓰레드가 사용을 끝낸 뒤 파괴한다. 남은 노드는 여기서 delete.
+	~EpochDomain()
+	{
+		m_threads.ForEach([](ThreadState& state) {
+			for (const Retired& r : state.retired) r.deleter(r.pointer);
+		});
+	}
+
+	EpochDomain(const EpochDomain&) = delete;
+	EpochDomain& operator=(const EpochDomain&) = delete;
+
+	// 읽기 구간. 살아 있는 동안 읽은 노드는 delete 되지 않는다. (중첩 가능)
+	class Guard
+	{
+	public:
+		Guard(Guard&& other) noexcept : m_domain(other.m_domain), m_state(std::exchange(other.m_state, nullptr)) {}
+		Guard& operator=(Guard&&) = delete;
+		~Guard()
+		{
+			if (m_state && --m_state->nesting == 0)
+				m_state->epoch.store(kInactive, std::memory_order_release);
+		}
+
+		// HazardDomain::Guard 와 같은 모양. epoch 는 구간 전체를 보호하므로 그냥 읽는다.
+		template <typename T>
+		T* Protect(size_t, const std::atomic<T*>& source) { return source.load(std::memory_order_acquire); }
+
+		// 이미 연결을 끊은 노드를 넘긴다. (노드를 끊은 쓰레드가 한 번만)
+		template <typename T>
+		void Retire(T* pointer) { m_domain->Retire(*m_state, pointer, [](void* p) { delete static_cast<T*>(p); }); }
+
+	private:
+		friend class EpochDomain;
+		Guard(EpochDomain* domain, ThreadState* state) : m_domain(domain), m_state(state) {}
+
+		EpochDomain* m_domain;
+		ThreadState* m_state;
+	};
+
+	Guard Pin()
+	{
+		ThreadState& state = m_threads.Local();
+		if (state.nesting++ == 0) {
+			state.epoch.store(m_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			// 이후의 노드 읽기보다 epoch 기록이 먼저 보이게. (TryAdvance 의 fence 와 짝)
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
+		return Guard(this, &state);
+	}
+
+	// 현재 쓰레드가 쌓아 둔 노드 중 회수할 수 있는 것을 지금 회수한다.
+	void Collect()
+	{
+		ThreadState& state = m_threads.Local();
+		TryAdvance();
+		Free(state);
+	}
+
+	// 아직 delete 되지 않은 노드 수.
+	size_t NumRetired() const { return m_numRetired.load(std::memory_order_relaxed); }
+	uint64_t Epoch() const { return m_epoch.load(std::memory_order_relaxed); }
+
+private:
+	void Retire(ThreadState& state, void* pointer, void (*deleter)(void*))
+	{
+		state.retired.push_back({ pointer, deleter, m_epoch.load(std::memory_order_relaxed) });
+		m_numRetired.fetch_add(1, std::memory_order_relaxed);
+		if (state.retired.size() >= m_batchSize) {
+			TryAdvance();
+			Free(state);
+		}
+	}
+
+	// 활성 쓰레드가 모두 현재 epoch 에 있으면 epoch 를 올린다.
+	bool TryAdvance()
+	{
+		uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		for (size_t i = 0; i < m_threads.NumSlots(); ++i) {
+			const uint64_t local = m_threads.At(i).epoch.load(std::memory_order_relaxed);
+			if (local != kInactive && local != epoch)
+				return false;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+	}
+
+	// 2 epoch 이상 지난 노드를 delete. (목록은 epoch 순서로 쌓여 있다)
+	void Free(ThreadState& state)
+	{
+		const uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+		auto it = state.retired.begin();
+		while (it != state.retired.end() && it->epoch + 2 <= epoch) {
+			it->deleter(it->pointer);
+			++it;
+		}
+		m_numRetired.fetch_sub(it - state.retired.begin(), std::memory_order_relaxed);
+		state.retired.erase(state.retired.begin(), it);
+	}
+
+	PerThread<ThreadState> m_threads;
+	size_t m_batchSize;
+	alignas(std::hardware_destructive_interference_size) std::atomic<uint64_t> m_epoch{ 0 };
+	alignas(std::hardware_destructive_interference_size) std::atomic<size_t> m_numRetired{ 0 };
+};
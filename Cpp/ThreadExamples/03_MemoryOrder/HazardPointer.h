@@ -0,0 +1,140 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "../07_FalseSharing/ShardedCounter.h"
+
+// lock-free 자료구조에서 떼어 낸 노드를 언제 delete 해도 되는지 정하는 방법 (2): hazard pointer (Michael, 2004)
+// - 노드를 읽기 전에 그 주소를 자기 hazard slot 에 게시하고, 원래 위치를 다시 읽어 그대로인지 확인한다. (Protect)
+// - 떼어 낸 노드는 Retire 로 쓰레드별 목록에 쌓고, scanThreshold 만큼 차면 모든 hazard slot 을 모아
+//   아무도 게시하지 않은 노드만 delete 한다.
+// - 포인터를 옮길 때마다 store + fence 가 필요해 EBR 보다 읽기가 느리지만,
+//   멈춘 쓰레드가 있어도 회수되지 못하는 노드는 그 쓰레드의 hazard 개수로 제한된다.
+// - 하위 1 bit 는 삭제 표시(mark) 로 보고 비교할 때 무시한다.
+class HazardDomain
+{
+public:
+	static constexpr size_t kHazardsPerThread = 3;
+
+private:
+	struct Retired
+	{
+		void* pointer;
+		void (*deleter)(void*);
+	};
+
+	struct ThreadState
+	{
+		std::atomic<void*> hazards[kHazardsPerThread]{}; // 다른 쓰레드가 읽음
+		std::vector<Retired> retired;                    // 이 slot 의 쓰레드만 사용
+	};
+
+	static uintptr_t Address(const void* pointer) { return reinterpret_cast<uintptr_t>(pointer) & ~uintptr_t(1); }
+
+public:
+	// numSlots: 동시에 살아 있는 쓰레드 수의 상한 (PerThread)
+	explicit HazardDomain(size_t numSlots = 128, size_t scanThreshold = 128)
+		: m_threads(numSlots), m_scanThreshold(scanThreshold) {}
+
+	// 모든 쓰레드가 사용을 끝낸 뒤 파괴한다. 남은 노드는 여기서 delete.
+	~HazardDomain()
+	{
+		m_threads.ForEach([](ThreadState& state) {
+			for (const Retired& r : state.retired) r.deleter(r.pointer);
+		});
+	}
+
+	HazardDomain(const HazardDomain&) = delete;
+	HazardDomain& operator=(const HazardDomain&) = delete;
+
+	// 현재 쓰레드의 hazard slot 묶음. 파괴될 때 모두 비운다. (쓰레드당 하나만)
+	class Guard
+	{
+	public:
+		Guard(Guard&& other) noexcept : m_domain(other.m_domain), m_state(std::exchange(other.m_state, nullptr)) {}
+		Guard& operator=(Guard&&) = delete;
+		~Guard()
+		{
+			if (!m_state)
+				return;
+			for (auto& hazard : m_state->hazards)
+				hazard.store(nullptr, std::memory_order_release);
+		}
+
+		// source 를 읽어 slot 에 게시한다. 게시 후 다시 읽은 값이 같을 때까지 반복.
+		// 돌려받은 노드는 같은 slot 에 다른 값을 게시하기 전까지 delete 되지 않는다.
+		template <typename T>
+		T* Protect(size_t slot, const std::atomic<T*>& source)
+		{
+			T* pointer = source.load(std::memory_order_relaxed);
+			while (true) {
+				m_state->hazards[slot].store(pointer, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst); // 게시가 다시 읽기보다 먼저 보이게 (Scan 의 fence 와 짝)
+				T* again = source.load(std::memory_order_acquire);
+				if (again == pointer)
+					return pointer;
+				pointer = again;
+			}
+		}
+
+		// 이미 연결을 끊은 노드를 넘긴다. (노드를 끊은 쓰레드가 한 번만)
+		template <typename T>
+		void Retire(T* pointer) { m_domain->Retire(*m_state, pointer, [](void* p) { delete static_cast<T*>(p); }); }
+
+	private:
+		friend class HazardDomain;
+		Guard(HazardDomain* domain, ThreadState* state) : m_domain(domain), m_state(state) {}
+
+		HazardDomain* m_domain;
+		ThreadState* m_state;
+	};
+
+	Guard Pin() { return Guard(this, &m_threads.Local()); }
+
+	// 현재 쓰레드가 쌓아 둔 노드 중 게시되지 않은 것을 지금 회수한다.
+	void Collect() { Scan(m_threads.Local()); }
+
+	// 아직 delete 되지 않은 노드 수.
+	size_t NumRetired() const { return m_numRetired.load(std::memory_order_relaxed); }
+
+private:
+	void Retire(ThreadState& state, void* pointer, void (*deleter)(void*))
+	{
+		state.retired.push_back({ pointer, deleter });
+		m_numRetired.fetch_add(1, std::memory_order_relaxed);
+		if (state.retired.size() >= m_scanThreshold)
+			Scan(state);
+	}
+
+	void Scan(ThreadState& state)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		thread_local std::vector<uintptr_t> hazards; // 매번 할당하지 않도록 재사용
+		hazards.clear();
+		for (size_t i = 0; i < m_threads.NumSlots(); ++i) {
+			for (const auto& hazard : m_threads.At(i).hazards) {
+				if (void* pointer = hazard.load(std::memory_order_acquire))
+					hazards.push_back(Address(pointer));
+			}
+		}
+		std::sort(hazards.begin(), hazards.end());
+
+		auto kept = std::partition(state.retired.begin(), state.retired.end(), [&](const Retired& r) {
+			return std::binary_search(hazards.begin(), hazards.end(), Address(r.pointer));
+		});
+		for (auto it = kept; it != state.retired.end(); ++it)
+			it->deleter(it->pointer);
+		m_numRetired.fetch_sub(state.retired.end() - kept, std::memory_order_relaxed);
+		state.retired.erase(kept, state.retired.end());
+	}
+
+	PerThread<ThreadState> m_threads;
+	size_t m_scanThreshold;
+	alignas(std::hardware_destructive_interference_size) std::atomic<size_t> m_numRetired{ 0 };
+};
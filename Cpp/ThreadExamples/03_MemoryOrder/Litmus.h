@@ -0,0 +1,265 @@
+﻿#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../06_ThreadPool/SpinWait.h"
+#include "../06_ThreadPool/Topology.h"
+
+// memory model litmus test 실행기.
+// - 쓰레드를 반복마다 만들지 않고, 고정(pin)된 쓰레드들이 spin barrier 로 맞춰 출발한다.
+// - 한 번 출발할 때 변수 묶음(batch) 전체를 차례로 실행하고, 끝나면 결과를 outcome 별로 센다.
+// - 같은 test 를 memory_order 만 바꿔 돌려서, SC 에서는 나올 수 없는 결과(weak) 가 몇 번 나오는지 비교한다.
+//   (나오지 않았다고 금지된 것은 아니다. CPU 구조에 따라 허용되어도 안 보일 수 있음: 예) x86 의 MP, LB)
+namespace Litmus
+{
+	inline const char* ToString(std::memory_order order)
+	{
+		switch (order) {
+		case std::memory_order_relaxed: return "relaxed";
+		case std::memory_order_consume: return "consume";
+		case std::memory_order_acquire: return "acquire";
+		case std::memory_order_release: return "release";
+		case std::memory_order_acq_rel: return "acq_rel";
+		default: return "seq_cst";
+		}
+	}
+
+	// 도착한 쓰레드 수를 세고, 마지막 쓰레드가 세대(generation) 를 넘긴다.
+	// 쓰레드가 CPU 보다 많으면 spin 만으로는 상대가 실행될 수 없으므로 잠깐 spin 후 yield 한다.
+	class SpinBarrier
+	{
+	public:
+		explicit SpinBarrier(size_t count) : m_count(count) {}
+
+		void ArriveAndWait()
+		{
+			const uint32_t generation = m_generation.load(std::memory_order_acquire);
+			if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count) {
+				m_arrived.store(0, std::memory_order_relaxed);
+				m_generation.store(generation + 1, std::memory_order_release);
+				return;
+			}
+			for (uint32_t spin = 0; m_generation.load(std::memory_order_acquire) == generation; ++spin) {
+				if (spin < 4096)
+					ThreadPool::CpuRelax();
+				else
+					std::this_thread::yield();
+			}
+		}
+
+	private:
+		const size_t m_count;
+		alignas(std::hardware_destructive_interference_size) std::atomic<size_t> m_arrived{ 0 };
+		alignas(std::hardware_destructive_interference_size) std::atomic<uint32_t> m_generation{ 0 };
+	};
+
+	// 서로 다른 cache-line 에 두는 변수. (같은 line 이면 일부 reordering 이 잘 안 보인다)
+	struct alignas(std::hardware_destructive_interference_size) Var
+	{
+		std::atomic<int> value{ 0 };
+	};
+
+	// outcome 별 횟수.
+	struct Result
+	{
+		std::string name;
+		std::vector<uint64_t> counts;     // outcome 번호별
+		std::vector<std::string> outcomes; // outcome 번호별 설명
+		uint32_t weakOutcome{ 0 };
+		uint64_t total{ 0 };
+		double seconds{ 0.0 };
+
+		uint64_t Weak() const { return counts[weakOutcome]; }
+	};
+
+	// test 형식:
+	//   kNumThreads, kNumOutcomes, kWeakOutcome, Name()
+	//   struct Vars;                            // test 한 번의 변수 (batch 로 배열을 만든다)
+	//   template <size_t T> static void Thread(Vars&);
+	//   static uint32_t Outcome(const Vars&);   // 결과 번호 (< kNumOutcomes)
+	//   static void Reset(Vars&);
+	//   static std::string Describe(uint32_t);  // 결과 번호 → "r0=1 r1=0"
+	template <class Test>
+	Result Run(size_t iterations, size_t batch = 1024)
+	{
+		constexpr size_t N = Test::kNumThreads;
+		std::vector<typename Test::Vars> vars(batch);
+		for (auto& v : vars) Test::Reset(v);
+
+		Result result;
+		result.name = Test::Name();
+		result.counts.assign(Test::kNumOutcomes, 0);
+		for (uint32_t o = 0; o < Test::kNumOutcomes; ++o)
+			result.outcomes.push_back(Test::Describe(o));
+		result.weakOutcome = Test::kWeakOutcome;
+		result.total = static_cast<uint64_t>(iterations) * batch;
+
+		const auto plan = ThreadPool::CpuTopology::Detect().Plan(ThreadPool::Placement::Spread, N);
+		SpinBarrier barrier(N);
+
+		// 쓰레드 T 의 반복. 0 번 쓰레드는 결과를 세고 변수를 초기화한다. (다른 쓰레드는 다음 출발 barrier 에서 대기)
+		auto body = [&]<size_t T>(std::integral_constant<size_t, T>) {
+			if (!plan.empty())
+				ThreadPool::PinCurrentThread(plan[T].id);
+			for (size_t it = 0; it < iterations; ++it) {
+				barrier.ArriveAndWait();
+				for (auto& v : vars)
+					Test::template Thread<T>(v);
+				barrier.ArriveAndWait();
+				if constexpr (T == 0) {
+					for (auto& v : vars) {
+						++result.counts[Test::Outcome(v)];
+						Test::Reset(v);
+					}
+				}
+			}
+		};
+
+		const auto stp = std::chrono::steady_clock::now();
+		[&]<size_t... T>(std::index_sequence<T...>) {
+			std::array<std::thread, N> threads{ std::thread(body, std::integral_constant<size_t, T>{})... };
+			for (auto& t : threads) t.join();
+		}(std::make_index_sequence<N>{});
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stp).count();
+		return result;
+	}
+
+	// Store Buffering
+	//   T0: x = 1; r0 = y      T1: y = 1; r1 = x
+	//   weak: r0 == 0 && r1 == 0  (store 가 store buffer 에 남은 채 뒤의 load 가 먼저 실행)
+	//   seq_cst 로만 금지된다. (release/acquire 로는 막지 못함)
+	template <std::memory_order Store, std::memory_order Load>
+	struct StoreBuffering
+	{
+		static constexpr size_t kNumThreads = 2;
+		static constexpr uint32_t kNumOutcomes = 4;
+		static constexpr uint32_t kWeakOutcome = 0;
+		static std::string Name() { return std::string("SB  store:") + ToString(Store) + " load:" + ToString(Load); }
+
+		struct Vars { Var x, y; int r0, r1; };
+
+		template <size_t T>
+		static void Thread(Vars& v)
+		{
+			if constexpr (T == 0) { v.x.value.store(1, Store); v.r0 = v.y.value.load(Load); }
+			else { v.y.value.store(1, Store); v.r1 = v.x.value.load(Load); }
+		}
+		static uint32_t Outcome(const Vars& v) { return v.r0 * 2 + v.r1; }
+		static void Reset(Vars& v) { v.x.value.store(0, std::memory_order_relaxed); v.y.value.store(0, std::memory_order_relaxed); v.r0 = v.r1 = -1; }
+		static std::string Describe(uint32_t o) { return std::format("r0={} r1={}", o / 2, o % 2); }
+	};
+
+	// SB 를 relaxed 접근 + 사이의 fence 로 막는 경우.
+	template <std::memory_order Fence>
+	struct StoreBufferingFence
+	{
+		static constexpr size_t kNumThreads = 2;
+		static constexpr uint32_t kNumOutcomes = 4;
+		static constexpr uint32_t kWeakOutcome = 0;
+		static std::string Name() { return std::string("SB  relaxed + fence:") + ToString(Fence); }
+
+		struct Vars { Var x, y; int r0, r1; };
+
+		template <size_t T>
+		static void Thread(Vars& v)
+		{
+			Var& mine = T == 0 ? v.x : v.y;
+			Var& other = T == 0 ? v.y : v.x;
+			mine.value.store(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(Fence);
+			(T == 0 ? v.r0 : v.r1) = other.value.load(std::memory_order_relaxed);
+		}
+		static uint32_t Outcome(const Vars& v) { return v.r0 * 2 + v.r1; }
+		static void Reset(Vars& v) { v.x.value.store(0, std::memory_order_relaxed); v.y.value.store(0, std::memory_order_relaxed); v.r0 = v.r1 = -1; }
+		static std::string Describe(uint32_t o) { return std::format("r0={} r1={}", o / 2, o % 2); }
+	};
+
+	// Message Passing
+	//   T0: data = 1; flag = 1      T1: r0 = flag; r1 = data
+	//   weak: r0 == 1 && r1 == 0  (flag 를 봤는데 data 가 안 보임)
+	//   flag 의 store 를 release, load 를 acquire 로 하면 금지된다.
+	template <std::memory_order Store, std::memory_order Load>
+	struct MessagePassing
+	{
+		static constexpr size_t kNumThreads = 2;
+		static constexpr uint32_t kNumOutcomes = 4;
+		static constexpr uint32_t kWeakOutcome = 2;
+		static std::string Name() { return std::string("MP  flag store:") + ToString(Store) + " load:" + ToString(Load); }
+
+		struct Vars { Var data, flag; int r0, r1; };
+
+		template <size_t T>
+		static void Thread(Vars& v)
+		{
+			if constexpr (T == 0) { v.data.value.store(1, std::memory_order_relaxed); v.flag.value.store(1, Store); }
+			else { v.r0 = v.flag.value.load(Load); v.r1 = v.data.value.load(std::memory_order_relaxed); }
+		}
+		static uint32_t Outcome(const Vars& v) { return v.r0 * 2 + v.r1; }
+		static void Reset(Vars& v) { v.data.value.store(0, std::memory_order_relaxed); v.flag.value.store(0, std::memory_order_relaxed); v.r0 = v.r1 = -1; }
+		static std::string Describe(uint32_t o) { return std::format("flag={} data={}", o / 2, o % 2); }
+	};
+
+	// Load Buffering
+	//   T0: r0 = x; y = 1      T1: r1 = y; x = 1
+	//   weak: r0 == 1 && r1 == 1  (load 보다 뒤의 store 가 먼저 보임)
+	//   load 를 acquire (또는 store 를 release) 로 하면 금지된다. x86 에서는 relaxed 라도 나오지 않는다.
+	template <std::memory_order Load, std::memory_order Store>
+	struct LoadBuffering
+	{
+		static constexpr size_t kNumThreads = 2;
+		static constexpr uint32_t kNumOutcomes = 4;
+		static constexpr uint32_t kWeakOutcome = 3;
+		static std::string Name() { return std::string("LB  load:") + ToString(Load) + " store:" + ToString(Store); }
+
+		struct Vars { Var x, y; int r0, r1; };
+
+		template <size_t T>
+		static void Thread(Vars& v)
+		{
+			if constexpr (T == 0) { v.r0 = v.x.value.load(Load); v.y.value.store(1, Store); }
+			else { v.r1 = v.y.value.load(Load); v.x.value.store(1, Store); }
+		}
+		static uint32_t Outcome(const Vars& v) { return v.r0 * 2 + v.r1; }
+		static void Reset(Vars& v) { v.x.value.store(0, std::memory_order_relaxed); v.y.value.store(0, std::memory_order_relaxed); v.r0 = v.r1 = -1; }
+		static std::string Describe(uint32_t o) { return std::format("r0={} r1={}", o / 2, o % 2); }
+	};
+
+	// Independent Reads of Independent Writes
+	//   T0: x = 1   T1: y = 1   T2: r0 = x; r1 = y   T3: r2 = y; r3 = x
+	//   weak: r0=1 r1=0 r2=1 r3=0  (두 reader 가 두 write 의 순서를 서로 다르게 봄)
+	//   seq_cst 로만 금지된다. x86 / ARMv8 은 multi-copy atomic 이라 acquire 로도 나오지 않고, POWER 에서는 나온다.
+	template <std::memory_order Store, std::memory_order Load>
+	struct IndependentReads
+	{
+		static constexpr size_t kNumThreads = 4;
+		static constexpr uint32_t kNumOutcomes = 16;
+		static constexpr uint32_t kWeakOutcome = 0b1010;
+		static std::string Name() { return std::string("IRIW store:") + ToString(Store) + " load:" + ToString(Load); }
+
+		struct Vars { Var x, y; int r0, r1, r2, r3; };
+
+		template <size_t T>
+		static void Thread(Vars& v)
+		{
+			if constexpr (T == 0) { v.x.value.store(1, Store); }
+			else if constexpr (T == 1) { v.y.value.store(1, Store); }
+			else if constexpr (T == 2) { v.r0 = v.x.value.load(Load); v.r1 = v.y.value.load(Load); }
+			else { v.r2 = v.y.value.load(Load); v.r3 = v.x.value.load(Load); }
+		}
+		static uint32_t Outcome(const Vars& v) { return (v.r0 << 3) | (v.r1 << 2) | (v.r2 << 1) | v.r3; }
+		static void Reset(Vars& v) { v.x.value.store(0, std::memory_order_relaxed); v.y.value.store(0, std::memory_order_relaxed); v.r0 = v.r1 = v.r2 = v.r3 = -1; }
+		static std::string Describe(uint32_t o) { return std::format("r0={} r1={} r2={} r3={}", (o >> 3) & 1, (o >> 2) & 1, (o >> 1) & 1, o & 1); }
+	};
+
+}  // namespace Litmus
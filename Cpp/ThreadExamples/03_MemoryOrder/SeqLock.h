@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include "../06_ThreadPool/SpinWait.h"
+
+// 읽기가 대부분인 공유 상태(설정, 카메라 등) 를 여러 쓰레드에 게시한다.
+// - writer 는 하나. 쓰기 전후로 sequence 를 올린다. (쓰는 중이면 홀수)
+// - reader 는 lock 없이 복사한 뒤 sequence 가 그대로인지 확인하고, 바뀌었으면(torn read) 다시 읽는다.
+//   reader 가 아무리 많아도 공유 cache-line 에 쓰지 않으므로 shared_mutex 처럼 reader 끼리 경합하지 않는다.
+// - 값은 atomic word 배열에 relaxed 로 읽고 써서 data race(UB) 가 되지 않게 한다.
+//   순서는 writer 의 release fence / reader 의 acquire fence 로 맞춘다. (Boehm, "Can Seqlocks Get Along With Programming Language Memory Models?")
+// - writer 가 너무 자주 쓰면 reader 가 계속 다시 읽게 된다. (writer 는 reader 를 기다리지 않음)
+template <typename T>
+	requires std::is_trivially_copyable_v<T>
+class SeqLock
+{
+public:
+	SeqLock() : SeqLock(T{}) {}
+	explicit SeqLock(const T& value) { WriteWords(value); }
+
+	SeqLock(const SeqLock&) = delete;
+	SeqLock& operator=(const SeqLock&) = delete;
+
+	// 일관된 값을 읽을 때까지 반복한다.
+	T Load() const
+	{
+		T value;
+		while (!TryLoad(value))
+			ThreadPool::CpuRelax();
+		return value;
+	}
+
+	// 한 번만 시도한다. 쓰는 중이었거나 읽는 동안 바뀌었으면 false.
+	bool TryLoad(T& value) const
+	{
+		const uint64_t begin = m_sequence.load(std::memory_order_acquire);
+		if (begin & 1)
+			return false;
+		ReadWords(value);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return m_sequence.load(std::memory_order_relaxed) == begin;
+	}
+
+	// writer 쓰레드 하나에서만 호출한다.
+	void Store(const T& value)
+	{
+		const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+		m_sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release); // 홀수 sequence 가 값보다 먼저 보이게
+		WriteWords(value);
+		m_sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	// 현재 값을 고쳐서 쓴다. (writer 전용: 다른 writer 가 없으므로 sequence 확인 없이 읽는다)
+	template <class F>
+	void Update(F&& f)
+	{
+		T value;
+		ReadWords(value);
+		f(value);
+		Store(value);
+	}
+
+	// 지금까지 Store 한 횟수.
+	uint64_t Version() const { return m_sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+	static constexpr size_t kNumWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	void ReadWords(T& value) const
+	{
+		uint64_t words[kNumWords];
+		for (size_t i = 0; i < kNumWords; ++i)
+			words[i] = m_words[i].load(std::memory_order_relaxed);
+		std::memcpy(&value, words, sizeof(T));
+	}
+
+	void WriteWords(const T& value)
+	{
+		uint64_t words[kNumWords]{};
+		std::memcpy(words, &value, sizeof(T));
+		for (size_t i = 0; i < kNumWords; ++i)
+			m_words[i].store(words[i], std::memory_order_relaxed);
+	}
+
+	alignas(std::hardware_destructive_interference_size) std::atomic<uint64_t> m_sequence{ 0 };
+	std::atomic<uint64_t> m_words[kNumWords];
+};
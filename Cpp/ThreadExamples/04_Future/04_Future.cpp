@@ -4,6 +4,14 @@
 #include <format>
 #include <string>
 #include <future>
+#include <functional>
+#include <vector>
+#include <chrono>
+
+#include "../06_ThreadPool/ThreadPool.h"
+#include "../06_ThreadPool/Async.h"
+#include "../06_ThreadPool/Future.h"
+#include "../06_ThreadPool/Task.h"
 
 //https://modoocode.com/284
 
@@ -99,6 +107,15 @@ void Test2_MyAsync()
 		std::cout << std::format("content1: {}\n", contentFuture1.get());
 		std::cout << std::format("content2: {}\n", contentFuture2.get());
 	}
+
+	// 요청마다 쓰레드를 만들어 detach 하는 대신 공용 pool 에서 실행.
+	{
+		auto contentFuture = ThreadPool::async([]() {
+			std::cout << "read file... \n";
+			return std::string("ABCDEFG from pool");
+			});
+		std::cout << "content: " << contentFuture.get() << std::endl;
+	}
 }
 
 void Test3_SharedFuture()
@@ -196,6 +213,171 @@ void Test4_PackagedTask_MyAsync()
 	std::cout << "MyAsync: " << future2.get() << std::endl;
 }
 
+// get() 으로 막지 않고 then / when_all / when_any 로 조합.
+void Test5_ContinuationFuture()
+{
+	std::cout << __func__ << std::endl;
+
+	ThreadPool::ThreadPool pool(2);
+
+	// then: 앞 단계가 끝나면 pool 에서 다음 단계를 실행.
+	{
+		ThreadPool::Promise<std::string> contentPromise;
+		auto lengthFuture = contentPromise.get_future()
+			.then(pool, [](std::string content) {
+				std::cout << std::format("then1: {}\n", content);
+				return content.size();
+			})
+			.then(pool, [](size_t length) {
+				std::cout << std::format("then2: length {}\n", length);
+				return length * 10;
+			});
+
+		pool.Post([p = std::move(contentPromise)]() mutable { p.set_value("ABCDEFG"); });
+		std::cout << std::format("result: {}\n", lengthFuture.get());
+	}
+
+	// 예외는 이후 단계를 건너뛰고 전달된다.
+	{
+		auto future = ThreadPool::make_ready_future(1)
+			.then(pool, [](int) -> int { throw std::runtime_error("read error"); })
+			.then(pool, [](int x) { std::cout << "not called\n"; return x; });
+		try {
+			future.get();
+		}
+		catch (const std::exception& e) {
+			std::cout << std::format("exception: {}\n", e.what());
+		}
+	}
+
+	// when_all / when_any
+	{
+		std::vector<ThreadPool::Promise<int>> promises(3);
+		std::vector<ThreadPool::Future<int>> futures1;
+		std::vector<ThreadPool::Future<int>> futures2;
+		for (auto& p : promises) futures1.push_back(p.get_future());
+		for (int i = 0; i < 3; ++i) futures2.push_back(ThreadPool::make_ready_future(i * 100));
+
+		auto any = ThreadPool::when_any(std::move(futures1)).then(pool, [](auto result) {
+			return std::format("when_any: index {}, value {}", result.index, result.futures[result.index].get());
+		});
+		auto all = ThreadPool::when_all(std::move(futures2)).then(pool, [](std::vector<ThreadPool::Future<int>> results) {
+			int sum = 0;
+			for (auto& f : results) sum += f.get();
+			return sum;
+		});
+
+		promises[1].set_value(11);
+		std::cout << any.get() << std::endl;
+		std::cout << std::format("when_all: sum {}\n", all.get());
+		promises[0].set_value(0);
+		promises[2].set_value(22);
+
+		auto both = ThreadPool::when_all(ThreadPool::make_ready_future(std::string("A")), ThreadPool::make_ready_future());
+		auto [a, v] = both.get();
+		v.get();
+		std::cout << std::format("when_all(tuple): {}\n", a.get());
+	}
+}
+
+// 1000 단계 chain 의 지연 시간 비교.
+// - std::async 중첩: 단계마다 쓰레드 하나가 앞 단계의 get() 에서 막혀 있다.
+// - Future::then: 막히는 쓰레드 없이 pool 에서 이어서 실행.
+void Test6_ChainLatency()
+{
+	std::cout << __func__ << std::endl;
+
+	using clock = std::chrono::steady_clock;
+	auto elapsedMs = [](clock::time_point stp) {
+		return std::chrono::duration<double, std::milli>(clock::now() - stp).count(); };
+
+	constexpr int numStages = 1000;
+
+	{
+		auto stp = clock::now();
+		std::future<int> f = std::async(std::launch::async, []() { return 0; });
+		for (int i = 0; i < numStages; ++i) {
+			f = std::async(std::launch::async, [prev = std::move(f)]() mutable { return prev.get() + 1; });
+		}
+		int result = f.get();
+		std::cout << std::format("std::async nested: result {}, total {:.3f} ms\n", result, elapsedMs(stp));
+	}
+
+	ThreadPool::ThreadPool pool(2);
+	{
+		auto stp = clock::now();
+		ThreadPool::Promise<int> source;
+		ThreadPool::Future<int> f = source.get_future();
+		for (int i = 0; i < numStages; ++i) {
+			f = std::move(f).then(pool, [](int x) { return x + 1; });
+		}
+		double buildMs = elapsedMs(stp);
+
+		auto runStp = clock::now();
+		source.set_value(0);
+		int result = f.get();
+		std::cout << std::format("Future::then    : result {}, total {:.3f} ms (build {:.3f} ms, run {:.3f} ms)\n",
+			result, elapsedMs(stp), buildMs, elapsedMs(runStp));
+	}
+}
+
+namespace coro
+{
+	// Test2_MyAsync 의 MyAsyncGetContent 를 coroutine 으로.
+	// detach 된 쓰레드 + promise 대신, pool 의 worker 로 옮겨 가서 실행하고 결과를 co_return.
+	ThreadPool::Task<std::string> MyAsyncGetContent(ThreadPool::ThreadPool& pool, std::string content)
+	{
+		co_await ThreadPool::schedule_on(pool);
+		std::cout << std::format("read file... {}\n", content);
+		co_return content;
+	}
+
+	ThreadPool::Task<size_t> GetTotalLength(ThreadPool::ThreadPool& pool)
+	{
+		std::string content1 = co_await MyAsyncGetContent(pool, "ABCDEF");
+		std::string content2 = co_await MyAsyncGetContent(pool, "FEDCBA");
+		co_return content1.size() + content2.size();
+	}
+
+	ThreadPool::Task<int> Throws(ThreadPool::ThreadPool& pool)
+	{
+		co_await ThreadPool::schedule_on(pool);
+		throw std::runtime_error("read error");
+	}
+
+	// 동기적으로 끝나는 co_await 가 깊게 중첩되어도 symmetric transfer 로 stack 이 쌓이지 않는다.
+	ThreadPool::Task<int> Depth(int n)
+	{
+		if (n == 0)
+			co_return 0;
+		co_return co_await Depth(n - 1) + 1;
+	}
+}
+
+void Test7_CoroutineTask()
+{
+	std::cout << __func__ << std::endl;
+
+	ThreadPool::ThreadPool pool(2);
+
+	std::cout << std::format("total length: {}\n", ThreadPool::sync_wait(coro::GetTotalLength(pool)));
+
+	try {
+		ThreadPool::sync_wait(coro::Throws(pool));
+	}
+	catch (const std::exception& e) {
+		std::cout << std::format("exception: {}\n", e.what());
+	}
+
+	// symmetric transfer 의 tail call 은 최적화 빌드에서만 보장된다. (Debug 는 깊이를 줄임)
+#ifdef NDEBUG
+	constexpr int depth = 1'000'000;
+#else
+	constexpr int depth = 10'000;
+#endif
+	std::cout << std::format("depth: {}\n", ThreadPool::sync_wait(coro::Depth(depth)));
+}
+
 int main()
 {
 	auto PrintSplitLines = []() {std::cout << std::format("{:-<{}}\n", "", 50); };
@@ -214,5 +396,14 @@ int main()
 
 	PrintSplitLines();
 	Test4_PackagedTask_MyAsync();
+
+	PrintSplitLines();
+	Test5_ContinuationFuture();
+
+	PrintSplitLines();
+	Test6_ChainLatency();
+
+	PrintSplitLines();
+	Test7_CoroutineTask();
 	return 0;
 }
\ No newline at end of file
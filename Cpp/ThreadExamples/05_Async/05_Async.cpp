@@ -4,6 +4,12 @@
 #include <format>
 #include <string>
 #include <future>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../06_ThreadPool/Async.h"
 
 //https://modoocode.com/284
 
@@ -37,9 +43,130 @@ void Teset1()
 	std::cout << "restult: " << ret;
 }
 
+// std::async 는 libstdc++ 에서 호출마다 쓰레드를 새로 만든다. (MSVC 는 내부 pool 사용)
+// ThreadPool::async 는 공용 pool(DefaultPool) 또는 지정한 pool 에서 실행한다.
+void Test2_PoolAsync()
+{
+	std::cout << __func__ << std::endl;
+
+	auto work = [](int time, int id) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(time + id));
+		std::cout << std::format("done: {}\n", id);
+		return id * 10;
+	};
+
+	// Teset1 과 같은 코드. executor 를 생략하면 DefaultPool.
+	auto f1 = ThreadPool::async(work, 200, 0);
+	auto f2 = ThreadPool::async(work, 200, 1);
+	int ret3 = work(200, 2);
+	int ret = f1.get() + f2.get() + ret3;
+	std::cout << std::format("result: {}\n", ret);
+
+	// 예외는 get() 에서 다시 던져진다.
+	ThreadPool::ThreadPool pool(2);
+	auto failed = ThreadPool::async(pool, []() -> int { throw std::runtime_error("read error"); });
+	try {
+		failed.get();
+	}
+	catch (const std::exception& e) {
+		std::cout << std::format("exception: {}\n", e.what());
+	}
+
+	// 바로 기다릴 작업은 Deferred: pool 에 넣지 않고 get() 하는 쓰레드가 실행한다.
+	const auto caller = std::this_thread::get_id();
+	auto deferred = ThreadPool::async(ThreadPool::Launch::Deferred, pool, [caller]() { return std::this_thread::get_id() == caller; });
+	std::cout << std::format("deferred ran on caller: {}\n", deferred.get());
+}
+
+namespace bench_async
+{
+	// 작은 작업 (수십 ns)
+	int SmallWork(int seed)
+	{
+		int x = seed;
+		for (int i = 0; i < 32; ++i) x = x * 1103515245 + 12345;
+		return x;
+	}
+
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
+		using clock = std::chrono::steady_clock;
+
+		constexpr int count = 100'000;
+		constexpr int batch = 64; // 한 번에 띄워 두는 작업 수
+		const auto caller = std::this_thread::get_id();
+		ThreadPool::ThreadPool& pool = ThreadPool::DefaultPool();
+
+		auto measure = [&](const char* name, auto&& body) {
+			int inlineRuns = 0;
+			long long sum = 0;
+			const auto stp = clock::now();
+			body(sum, inlineRuns);
+			const double ms = std::chrono::duration<double, std::milli>(clock::now() - stp).count();
+			std::cout << std::format("{:<34}: {:>9.1f} ms, {:>8.0f} ns/call, ran on caller: {:>6} (sum {})\n",
+				name, ms, ms * 1e6 / count, inlineRuns, sum);
+		};
+		auto task = [caller](int i, int* inlineRuns) {
+			if (std::this_thread::get_id() == caller) ++*inlineRuns;
+			return SmallWork(i);
+		};
+
+		// 호출 직후 get()
+		measure("std::async + get", [&](long long& sum, int& inlineRuns) {
+			for (int i = 0; i < count; ++i)
+				sum += std::async(std::launch::async, task, i, &inlineRuns).get();
+		});
+		measure("std::thread + promise + get", [&](long long& sum, int& inlineRuns) {
+			for (int i = 0; i < count; ++i) {
+				std::promise<int> promise;
+				std::future<int> future = promise.get_future();
+				std::thread t([&task, &inlineRuns, i](std::promise<int> p) { p.set_value(task(i, &inlineRuns)); }, std::move(promise));
+				sum += future.get();
+				t.join();
+			}
+		});
+		measure("ThreadPool::async + get", [&](long long& sum, int& inlineRuns) {
+			for (int i = 0; i < count; ++i)
+				sum += ThreadPool::async(pool, task, i, &inlineRuns).get();
+		});
+		measure("ThreadPool::async(Deferred) + get", [&](long long& sum, int& inlineRuns) {
+			for (int i = 0; i < count; ++i)
+				sum += ThreadPool::async(ThreadPool::Launch::Deferred, pool, task, i, &inlineRuns).get();
+		});
+
+		// batch 개씩 띄운 뒤 모아서 get() (실제로 병렬 실행)
+		// inlineRuns 는 호출자 쓰레드에서만 증가하므로 worker 와 경합하지 않는다.
+		measure("std::async x64 then get", [&](long long& sum, int& inlineRuns) {
+			std::vector<std::future<int>> futures;
+			for (int i = 0; i < count; i += batch) {
+				for (int k = i; k < std::min(i + batch, count); ++k)
+					futures.push_back(std::async(std::launch::async, task, k, &inlineRuns));
+				for (auto& f : futures) sum += f.get();
+				futures.clear();
+			}
+		});
+		measure("ThreadPool::async x64 then get", [&](long long& sum, int& inlineRuns) {
+			std::vector<ThreadPool::AsyncFuture<int>> futures;
+			for (int i = 0; i < count; i += batch) {
+				for (int k = i; k < std::min(i + batch, count); ++k)
+					futures.push_back(ThreadPool::async(pool, task, k, &inlineRuns));
+				for (auto& f : futures) sum += f.get();
+				futures.clear();
+			}
+		});
+	}
+}
+
 int main()
 {
 	PrintSplitLines();
 	Teset1();
+
+	PrintSplitLines();
+	Test2_PoolAsync();
+
+	PrintSplitLines();
+	bench_async::Run();
 	return 0;
 }
\ No newline at end of file
@@ -1,122 +1,1161 @@
-﻿#include <chrono>
-#include <condition_variable>
+﻿#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <functional>
 #include <future>
+#include <iostream>
+#include <latch>
 #include <mutex>
-#include <queue>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
 #include <thread>
 #include <vector>
-#include <utility>
 #include <format>
-//https://modoocode.com/285
 
+#include "ThreadPool.h"
+#include "ParallelFor.h"
+#include "TaskGraph.h"
+#include "TaskGroup.h"
+#include "WaitGroup.h"
+#include "../../benchmark.h"
 
-namespace ThreadPool
+// 할당 횟수 측정을 위해 전역 operator new/delete 를 교체.
+// 일반 / nothrow / 정렬(align_val_t) 형태를 모두 센다. (배열 new[] 는 기본 구현이 이것들을 부른다)
+namespace alloc_count
 {
-	class ThreadPool
+	std::atomic<size_t> g_numAllocations{ 0 };
+
+	void* Allocate(std::size_t size) noexcept
+	{
+		g_numAllocations.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size ? size : 1);
+	}
+
+	// 원래 포인터를 정렬된 블록 바로 앞에 적어 둔다. (MSVC 에는 std::aligned_alloc 이 없음)
+	void* AllocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+	{
+		g_numAllocations.fetch_add(1, std::memory_order_relaxed);
+		const std::size_t align = static_cast<std::size_t>(alignment);
+		void* raw = std::malloc(size + align + sizeof(void*));
+		if (!raw)
+			return nullptr;
+		const std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(align - 1);
+		reinterpret_cast<void**>(aligned)[-1] = raw;
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	void FreeAligned(void* ptr) noexcept
+	{
+		if (ptr)
+			std::free(reinterpret_cast<void**>(ptr)[-1]);
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	if (void* ptr = alloc_count::Allocate(size))
+		return ptr;
+	throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return alloc_count::Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (void* ptr = alloc_count::AllocateAligned(size, alignment))
+		return ptr;
+	throw std::bad_alloc();
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return alloc_count::AllocateAligned(size, alignment);
+}
+
+// delete 본체가 호출한 곳에 inline 되면 GCC 는 new 로 받은 포인터를 free 하는 것으로 보고 경고한다. (-Wmismatched-new-delete)
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { ::operator delete(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { ::operator delete(ptr); }
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* ptr, std::align_val_t) noexcept { alloc_count::FreeAligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept { ::operator delete(ptr, alignment); }
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept { ::operator delete(ptr, alignment); }
+
+int work(int t, int id) 
+{
+	printf("%d start \n", id);
+	std::this_thread::sleep_for(std::chrono::seconds(t));
+	printf("%d end after %ds\n", id, t);
+	return id;
+}
+
+void Test1_Basic()
+{
+	std::cout << __func__ << std::endl;
+
+	ThreadPool::ThreadPool pool(3);
+
+	std::vector<std::future<int>> futures;
+	for (int i = 0; i < 10; i++) {
+		futures.emplace_back(pool.EnqueueJob(work, i % 3 + 1, i));
+	}
+	for (auto& f : futures) {
+		printf("result : %d \n", f.get());
+	}
+}
+
+// 작은 lambda 제출이 정상 상태에서 heap 할당 0 회인지 확인.
+void Test2_AllocationFreeSubmit()
+{
+	std::cout << __func__ << std::endl;
+
+	constexpr size_t numThread = 4;
+	constexpr size_t numJobs = 10000;
+
+	for (auto mode : { ThreadPool::SchedulingMode::GlobalQueue, ThreadPool::SchedulingMode::WorkStealing })
+	{
+		ThreadPool::ThreadPool pool(numThread, mode);
+		std::vector<std::future<int>> futures;
+		futures.reserve(numJobs);
+
+		auto submitAll = [&]() {
+			for (size_t i = 0; i < numJobs; ++i) {
+				futures.emplace_back(pool.EnqueueJob([](int x) { return x + 1; }, static_cast<int>(i)));
+			}
+			int64_t sum = 0;
+			for (auto& f : futures) sum += f.get();
+			futures.clear();
+			return sum;
+		};
+
+		// warm-up: 모든 worker 를 잠시 막아 두고 전부 queue 에 쌓이게 해서
+		// JobQueue 용량과 BlockPool free-list 를 최대치까지 준비.
+		{
+			std::latch started(numThread);
+			std::atomic<bool> release{ false };
+			std::vector<std::future<void>> blockers;
+			for (size_t i = 0; i < numThread; ++i) {
+				blockers.emplace_back(pool.EnqueueJob([&]() {
+					started.arrive_and_wait();
+					while (!release) std::this_thread::yield();
+				}));
+			}
+			started.wait();
+			for (size_t i = 0; i < numJobs; ++i) {
+				futures.emplace_back(pool.EnqueueJob([](int x) { return x + 1; }, static_cast<int>(i)));
+			}
+			release = true;
+			for (auto& f : blockers) f.get();
+			for (auto& f : futures) f.get();
+			futures.clear();
+		}
+
+		size_t before = alloc_count::g_numAllocations.load();
+		int64_t sum = submitAll();
+		size_t allocations = alloc_count::g_numAllocations.load() - before;
+
+		std::cout << std::format("{}: jobs: {}, sum: {}, allocations: {} -> {}\n",
+			mode == ThreadPool::SchedulingMode::GlobalQueue ? "global  " : "stealing",
+			numJobs, sum, allocations, allocations == 0 ? "OK" : "FAIL");
+	}
+}
+
+// chunk 마다 EnqueueJob + future 를 모으던 방식과 parallel_for / parallel_reduce 비교.
+void Test3_ParallelFor()
+{
+	std::cout << __func__ << std::endl;
+
+	using clock = std::chrono::steady_clock;
+	auto elapsedMs = [](clock::time_point stp) {
+		return std::chrono::duration<double, std::milli>(clock::now() - stp).count(); };
+
+	constexpr size_t count = 10'000'000;
+	constexpr size_t grain = 64 * 1024;
+	ThreadPool::ThreadPool pool(std::thread::hardware_concurrency(), ThreadPool::SchedulingMode::WorkStealing);
+	std::vector<double> data(count);
+
+	ThreadPool::parallel_for(pool, { 0, count }, grain, [&data](size_t i) {
+		data[i] = static_cast<double>(i) * 0.5;
+	});
+
+	// 기존 방식: 직접 나누고 chunk 마다 future.
+	{
+		auto stp = clock::now();
+		std::vector<std::future<double>> futures;
+		for (size_t begin = 0; begin < count; begin += grain) {
+			const size_t end = std::min(begin + grain, count);
+			futures.emplace_back(pool.EnqueueJob([&data, begin, end]() {
+				double sum = 0.0;
+				for (size_t i = begin; i < end; ++i) sum += data[i];
+				return sum;
+			}));
+		}
+		double sum = 0.0;
+		for (auto& f : futures) sum += f.get();
+		std::cout << std::format("futures({} chunks): sum: {:.1f}, {:.2f} ms\n", futures.size(), sum, elapsedMs(stp));
+	}
+
+	// parallel_reduce: 호출자는 마지막에 한 번만 대기.
 	{
-	public:
-		ThreadPool(size_t numThread);
-		~ThreadPool();
+		auto stp = clock::now();
+		double sum = ThreadPool::parallel_reduce(pool, { 0, count }, grain, 0.0,
+			[&data](ThreadPool::Range r, double acc) {
+				for (size_t i = r.begin; i < r.end; ++i) acc += data[i];
+				return acc;
+			},
+			[](double a, double b) { return a + b; });
+		std::cout << std::format("parallel_reduce: sum: {:.1f}, {:.2f} ms\n", sum, elapsedMs(stp));
+	}
+
+	double expected = std::accumulate(data.begin(), data.end(), 0.0);
+	std::cout << std::format("expected: {:.1f}\n", expected);
+}
+
+// 10k 노드 DAG 를 worker 2개짜리 pool 에서 여러 frame 재사용.
+// (작업 안에서 future.get() 으로 기다리는 방식은 worker 수가 적으면 deadlock)
+void Test4_TaskGraph()
+{
+	std::cout << __func__ << std::endl;
+
+	constexpr size_t numLayers = 100;
+	constexpr size_t nodesPerLayer = 100;
+	constexpr size_t numNodes = numLayers * nodesPerLayer;
+	constexpr size_t numFrames = 5;
+
+	ThreadPool::ThreadPool pool(2);
+	ThreadPool::TaskGraph graph;
+
+	// 노드마다 몇 번째 frame 까지 끝났는지 기록하고, 선행 노드가 먼저 끝났는지 검사.
+	std::vector<std::atomic<size_t>> finishedFrame(numNodes);
+	std::vector<std::vector<size_t>> predecessors(numNodes);
+	std::atomic<size_t> frame{ 0 };
+	std::atomic<size_t> orderErrors{ 0 };
+
+	for (size_t id = 0; id < numNodes; ++id) {
+		graph.AddNode([&, id]() {
+			const size_t current = frame.load(std::memory_order_relaxed);
+			for (size_t pred : predecessors[id]) {
+				if (finishedFrame[pred].load(std::memory_order_acquire) != current)
+					orderErrors.fetch_add(1, std::memory_order_relaxed);
+			}
+			finishedFrame[id].store(current, std::memory_order_release);
+		});
+	}
 
-		// job 을 추가한다.
-		template <class F, class... Args>
-		std::future<std::invoke_result_t<F, Args...>>
-			EnqueueJob(F&& f, Args&&... args);
+	// 각 노드는 바로 앞 layer 의 임의 노드 3개에 의존.
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<size_t> pick(0, nodesPerLayer - 1);
+	for (size_t layer = 1; layer < numLayers; ++layer) {
+		for (size_t i = 0; i < nodesPerLayer; ++i) {
+			const size_t to = layer * nodesPerLayer + i;
+			for (int e = 0; e < 3; ++e) {
+				const size_t from = (layer - 1) * nodesPerLayer + pick(rng);
+				graph.AddEdge(from, to);
+				predecessors[to].push_back(from);
+			}
+		}
+	}
 
-	private:		
-		void WorkerThread(); // Worker 쓰레드
+	for (size_t f = 1; f <= numFrames; ++f) {
+		frame = f;
+		auto stp = std::chrono::steady_clock::now();
+		graph.Run(pool);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stp).count();
+
+		size_t notFinished = 0;
+		for (auto& finished : finishedFrame) {
+			if (finished.load() != f) ++notFinished;
+		}
+		std::cout << std::format("frame {}: nodes: {}, not finished: {}, order errors: {}, {:.2f} ms\n",
+			f, graph.GetNumNodes(), notFinished, orderErrors.load(), ms);
+	}
+}
 
-	private:
-		std::vector<std::thread> m_workerThreads;
+// 배경 작업이 몰려 있을 때 지연에 민감한 작업의 queue 대기 시간.
+// - fifo : 모든 작업이 Normal lane (기존 FIFO 와 같음)
+// - lanes: 급한 작업은 High, 배경 작업은 Low
+// 그리고 High 가 계속 쌓여 있어도 Low 가 최소 몫은 처리되는지 확인.
+void Test5_PriorityLanes()
+{
+	std::cout << __func__ << std::endl;
 
-		// 작업 보관
-		std::queue<std::function<void()>> m_jobs;
-		std::condition_variable m_cvForJobs;
-		std::mutex m_mutexForJobs;
+	using clock = std::chrono::steady_clock;
+	using ThreadPool::Priority;
 
-		// 모든 쓰레드 종료
-		bool m_stopAll{ false };
+	constexpr size_t numThread = 4;
+	constexpr size_t numBackground = 200'000;
+	constexpr size_t numCritical = 2'000;
 
+	auto spin = [](uint64_t x) {
+		for (int i = 0; i < 256; ++i) { x ^= x << 13; x ^= x >> 7; x ^= x << 17; }
+		return x;
 	};
+	auto ns = [](const clock::duration& d) { return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(); };
 
-	ThreadPool::ThreadPool(size_t numThread)
+	for (auto mode : { ThreadPool::SchedulingMode::GlobalQueue, ThreadPool::SchedulingMode::WorkStealing })
 	{
-		m_workerThreads.reserve(numThread);
-		for (size_t i = 0; i < numThread; ++i) {
-			m_workerThreads.emplace_back([this]() { this->WorkerThread(); });
+		for (bool useLanes : { false, true })
+		{
+			ThreadPool::ThreadPool pool(numThread, mode);
+			pool.EnableQueueWaitMetrics(true);
+
+			std::atomic<uint64_t> sink{ 0 };
+			std::vector<int64_t> criticalWaits(numCritical);
+			ThreadPool::WaitGroup done(numBackground + numCritical);
+
+			// 배경 작업은 별도 쓰레드가 쉬지 않고 넣는다.
+			std::thread feeder([&]() {
+				for (size_t i = 0; i < numBackground; ++i) {
+					pool.Post(useLanes ? Priority::Low : Priority::Normal, [&, i]() {
+						sink.fetch_add(spin(i + 1), std::memory_order_relaxed);
+						done.Done();
+					});
+				}
+			});
+
+			// 급한 작업은 20us 간격으로 넣고, 실행되기까지 기다린 시간을 직접 잰다.
+			for (size_t i = 0; i < numCritical; ++i) {
+				const auto enqueued = clock::now();
+				pool.Post(useLanes ? Priority::High : Priority::Normal, [&, i, enqueued]() {
+					criticalWaits[i] = ns(clock::now() - enqueued);
+					done.Done();
+				});
+				while (clock::now() - enqueued < std::chrono::microseconds(20)) {}
+			}
+			feeder.join();
+			done.Wait();
+
+			std::sort(criticalWaits.begin(), criticalWaits.end());
+			std::cout << std::format("{} {}: critical wait p50: {} ns, p99: {} ns\n",
+				mode == ThreadPool::SchedulingMode::GlobalQueue ? "global  " : "stealing",
+				useLanes ? "lanes" : "fifo ",
+				criticalWaits[numCritical / 2], criticalWaits[numCritical * 99 / 100]);
+			for (auto priority : { Priority::High, Priority::Normal, Priority::Low }) {
+				const auto latency = pool.GetQueueWaitLatency(priority);
+				if (latency.Count() == 0)
+					continue;
+				std::cout << std::format("    lane {}: jobs: {}, p50: <={} ns, p99: <={} ns, max: {} ns\n",
+					static_cast<int>(priority), latency.Count(), latency.Percentile(0.50),
+					latency.Percentile(0.99), latency.Max());
+			}
 		}
 	}
 
-	ThreadPool::~ThreadPool()
+	// starvation 방지: worker 1개를 막아 두고 High 1700 개 + Low 100 개를 쌓은 뒤 실행 순서를 본다.
 	{
-		m_stopAll = true;
-		m_cvForJobs.notify_all();
-		for (auto& t : m_workerThreads) {
-			t.join();
+		ThreadPool::ThreadPool pool(1);
+		std::atomic<bool> release{ false };
+		pool.Post([&]() { while (!release) std::this_thread::yield(); });
+
+		constexpr size_t numHigh = 1700;
+		constexpr size_t numLow = 100;
+		std::atomic<size_t> order{ 0 };
+		std::atomic<size_t> lowDoneWhileHighQueued{ 0 };
+		std::atomic<size_t> numHighDone{ 0 };
+		ThreadPool::WaitGroup done(numHigh + numLow);
+		for (size_t i = 0; i < numHigh; ++i) {
+			pool.Post(Priority::High, [&]() { ++order; ++numHighDone; done.Done(); });
+		}
+		for (size_t i = 0; i < numLow; ++i) {
+			pool.Post(Priority::Low, [&]() {
+				++order;
+				if (numHighDone < numHigh) ++lowDoneWhileHighQueued;
+				done.Done();
+			});
 		}
+		release = true;
+		done.Wait();
+		std::cout << std::format("starvation: Low done while High queued: {} / {} (expected >= {})\n",
+			lowDoneWhileHighQueued.load(), numLow, numHigh / 17);
 	}
+}
+
+// 취소 / 기한 / Shutdown(Discard) / 과부하 시 버리기.
+void Test6_Cancellation()
+{
+	std::cout << __func__ << std::endl;
+
+	using ThreadPool::CancelReason;
+	using ThreadPool::JobCancelled;
+
+	auto reasonOf = [](auto& future) {
+		try { future.get(); }
+		catch (const JobCancelled& e) { return e.Reason(); }
+		return CancelReason::None;
+	};
 
-	void ThreadPool::WorkerThread() 
+	for (auto mode : { ThreadPool::SchedulingMode::GlobalQueue, ThreadPool::SchedulingMode::WorkStealing })
 	{
-		while (true) 
+		std::cout << (mode == ThreadPool::SchedulingMode::GlobalQueue ? "global\n" : "stealing\n");
+
+		// worker 1개를 막아 두고 작업을 쌓은 뒤 취소 / 기한 초과.
+		{
+			ThreadPool::ThreadPool pool(1, mode);
+			std::latch started(1);
+			std::atomic<bool> release{ false };
+			pool.Post([&]() { started.count_down(); while (!release) std::this_thread::yield(); });
+			started.wait();
+
+			std::stop_source source;
+			ThreadPool::JobOptions cancellable;
+			cancellable.stopToken = source.get_token();
+			ThreadPool::JobOptions expiring;
+			expiring.timeout = std::chrono::milliseconds(5);
+
+			std::atomic<int> numRun{ 0 };
+			std::vector<std::future<int>> cancelled;
+			std::vector<std::future<int>> expired;
+			for (int i = 0; i < 10; ++i) {
+				cancelled.push_back(pool.EnqueueJob(cancellable, [&](int x) { ++numRun; return x; }, i));
+				expired.push_back(pool.EnqueueJob(expiring, [&](int x) { ++numRun; return x; }, i));
+			}
+			auto kept = pool.EnqueueJob([](int x) { return x * 2; }, 21);
+
+			source.request_stop();
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			release = true;
+
+			int numCancelled = 0, numExpired = 0;
+			for (auto& f : cancelled) numCancelled += reasonOf(f) == CancelReason::Cancelled;
+			for (auto& f : expired) numExpired += reasonOf(f) == CancelReason::Timeout;
+			std::cout << std::format("  cancelled: {}/10, expired: {}/10, run: {}, kept: {} -> {}\n",
+				numCancelled, numExpired, numRun.load(), kept.get(),
+				numCancelled == 10 && numExpired == 10 && numRun == 0 ? "OK" : "FAIL");
+		}
+
+		// Shutdown(Discard): 실행 중인 작업은 token 을 보고 멈추고, 남은 작업은 버려진다.
 		{
-			std::unique_lock<std::mutex> lock(m_mutexForJobs);
-			m_cvForJobs.wait(lock, [this]() { return !this->m_jobs.empty() || m_stopAll; });
-			if (m_stopAll && this->m_jobs.empty()) {
-				// 전체 중단 및 작업이 없는 경우 종료.
+			ThreadPool::ThreadPool pool(2, mode);
+			std::latch started(2);
+			std::vector<std::future<int>> running;
+			for (int i = 0; i < 2; ++i) {
+				running.push_back(pool.EnqueueJob(ThreadPool::JobOptions{}, [&](std::stop_token token) {
+					started.count_down();
+					int polls = 0;
+					while (!token.stop_requested()) { ++polls; std::this_thread::yield(); }
+					return polls;
+				}));
+			}
+			started.wait();
+			std::vector<std::future<void>> queued;
+			for (int i = 0; i < 100; ++i) queued.push_back(pool.EnqueueJob([]() {}));
+
+			pool.Shutdown(ThreadPool::ShutdownMode::Discard);
+			int numStopped = 0, numDiscarded = 0;
+			for (auto& f : running) numStopped += f.get() > 0;
+			for (auto& f : queued) numDiscarded += reasonOf(f) == CancelReason::Shutdown;
+			std::cout << std::format("  discard: running stopped: {}/2, queued discarded: {}/100 -> {}\n",
+				numStopped, numDiscarded, numStopped == 2 && numDiscarded == 100 ? "OK" : "FAIL");
+		}
+	}
+
+	// queue 상한이 있어도 parallel_for / TaskGroup 의 내부 작업(일반 Post) 은 버리지 않는다. (버리면 Wait 가 끝나지 않음)
+	for (auto mode : { ThreadPool::SchedulingMode::GlobalQueue, ThreadPool::SchedulingMode::WorkStealing })
+	{
+		ThreadPool::ThreadPoolOptions options;
+		options.mode = mode;
+		options.maxQueuedJobs = 4;
+		ThreadPool::ThreadPool pool(2, options);
+
+		std::atomic<size_t> numIndices{ 0 };
+		ThreadPool::parallel_for(pool, { 0, 100'000 }, 1, [&](size_t) { numIndices.fetch_add(1, std::memory_order_relaxed); });
+		std::atomic<int> numTasks{ 0 };
+		ThreadPool::TaskGroup group(pool);
+		for (int i = 0; i < 100; ++i) group.Run([&]() { ++numTasks; });
+		group.Wait();
+
+		std::cout << std::format("{} maxQueued 4: parallel_for: {}/100000, TaskGroup: {}/100, shed: {} -> {}\n",
+			mode == ThreadPool::SchedulingMode::GlobalQueue ? "global" : "stealing",
+			numIndices.load(), numTasks.load(), pool.GetNumCancelled(CancelReason::Shed),
+			numIndices == 100'000 && numTasks == 100 && pool.GetNumCancelled(CancelReason::Shed) == 0 ? "OK" : "FAIL");
+	}
+
+	// 과부하: 처리량보다 빠르게 들어오는 요청. 끝까지 다 처리하면 대기 시간이 계속 늘어나고,
+	// queue 상한을 두고 오래된 작업을 버리면 처리되는 작업의 대기 시간이 상한 근처에 머문다.
+	// (버려도 되는 요청이므로 Post(JobOptions) 로 넣는다)
+	for (size_t maxQueued : { size_t(0), size_t(256) })
+	{
+		ThreadPool::ThreadPoolOptions options;
+		options.maxQueuedJobs = maxQueued;
+		ThreadPool::ThreadPool pool(2, options);
+		pool.EnableQueueWaitMetrics(true);
+
+		constexpr int numRequests = 20'000;
+		std::atomic<uint64_t> sink{ 0 };
+		for (int i = 0; i < numRequests; ++i) {
+			pool.Post(ThreadPool::JobOptions{}, [&, i]() {
+				uint64_t x = i + 1;
+				for (int k = 0; k < 2000; ++k) { x ^= x << 13; x ^= x >> 7; x ^= x << 17; }
+				sink.fetch_add(x, std::memory_order_relaxed);
+			});
+		}
+		pool.Shutdown();
+
+		const auto wait = pool.GetQueueWaitLatency(ThreadPool::Priority::Normal);
+		std::cout << std::format("overload maxQueued {:>3}: run: {:>5}, shed: {:>5}, wait p50: <={} ns, p99: <={} ns\n",
+			maxQueued, wait.Count(), pool.GetNumCancelled(CancelReason::Shed),
+			wait.Percentile(0.50), wait.Percentile(0.99));
+	}
+}
+
+// 지연 / 반복 작업. work() 처럼 작업 안에서 sleep_for 하면 그동안 worker 하나를 차지하지만,
+// EnqueueAfter 는 타이머 쓰레드가 기다렸다가 때가 되면 넣기만 한다.
+void Test7_Timers()
+{
+	std::cout << __func__ << std::endl;
+
+	using clock = std::chrono::steady_clock;
+	using namespace std::chrono_literals;
+
+	ThreadPool::ThreadPool pool(1);
+	const auto start = clock::now();
+	auto elapsedMs = [&]() { return std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count(); };
+
+	// worker 가 1 개여도 지연 작업들이 서로를 막지 않는다.
+	std::mutex mutex;
+	std::vector<std::string> log;
+	ThreadPool::WaitGroup done(4);
+	for (int delayMs : { 50, 10, 30, 20 }) {
+		pool.EnqueueAfter(std::chrono::milliseconds(delayMs), [&, delayMs]() {
+			std::lock_guard<std::mutex> lock(mutex);
+			log.push_back(std::format("{}ms@{}", delayMs, elapsedMs()));
+			done.Done();
+		});
+	}
+	std::atomic<bool> cancelledRan{ false };
+	auto cancelled = pool.EnqueueAfter(30ms, [&]() { cancelledRan = true; });
+	std::cout << std::format("cancel before firing: {}\n", pool.CancelTimer(cancelled));
+
+	std::atomic<int> ticks{ 0 };
+	auto periodic = pool.EnqueueEvery(10ms, [&]() { ++ticks; });
+
+	done.Wait();
+	std::string order;
+	for (auto& entry : log) order += entry + " ";
+	std::cout << std::format("order: {}\n", order);
+
+	std::this_thread::sleep_for(55ms);
+	pool.CancelTimer(periodic);
+	const int ticksAtCancel = ticks;
+	std::this_thread::sleep_for(30ms);
+	std::cout << std::format("periodic 10ms: {} runs in ~{}ms, after cancel: {} -> {}\n",
+		ticksAtCancel, elapsedMs() - 30, ticks - ticksAtCancel,
+		ticks == ticksAtCancel && !cancelledRan ? "OK" : "FAIL");
+}
+
+// 작업 안에서 다른 작업의 결과를 기다리기.
+// worker 3개 pool 에 "자식 작업을 넣고 future.get()" 하는 작업이 3개 이상 들어오면 모든 worker 가 막혀 deadlock.
+// Await / TaskGroup::Wait 는 기다리는 동안 queue 의 작업을 대신 실행한다.
+void Test8_HelpWhileWaiting()
+{
+	std::cout << __func__ << std::endl;
+
+	using clock = std::chrono::steady_clock;
+	auto elapsedMs = [](clock::time_point stp) {
+		return std::chrono::duration<double, std::milli>(clock::now() - stp).count(); };
+
+	for (auto mode : { ThreadPool::SchedulingMode::GlobalQueue, ThreadPool::SchedulingMode::WorkStealing }) {
+		ThreadPool::ThreadPool pool(3, mode);
+
+		// 부모 작업 8개가 각자 자식을 넣고 기다린다. (get() 이었다면 부모 3개가 worker 를 모두 잡고 멈춤)
+		std::vector<std::future<int>> parents;
+		for (int i = 0; i < 8; ++i) {
+			parents.push_back(pool.EnqueueJob([&pool, i]() {
+				auto child = pool.EnqueueJob([i]() { return i * 10; });
+				return pool.Await(child) + 1;
+			}));
+		}
+		int sum = 0;
+		for (auto& parent : parents) sum += parent.get();
+
+		// 재귀 fib: 기다림이 깊이 20 까지 중첩된다.
+		std::function<uint64_t(int)> fib = [&](int n) -> uint64_t {
+			if (n < 2) return n;
+			auto left = pool.EnqueueJob(fib, n - 1);
+			const uint64_t right = fib(n - 2);
+			return pool.Await(left) + right;
+		};
+		const uint64_t fib20 = pool.Await(pool.EnqueueJob(fib, 20));
+
+		// 작업 안의 parallel_for 도 같은 방식으로 기다린다.
+		std::atomic<size_t> nested{ 0 };
+		ThreadPool::TaskGroup outer(pool);
+		for (int i = 0; i < 6; ++i) {
+			outer.Run([&]() {
+				ThreadPool::parallel_for(pool, { 0, 1000 }, 10, [&](size_t) { nested.fetch_add(1, std::memory_order_relaxed); });
+			});
+		}
+		outer.Wait();
+
+		// parallel_reduce 안의 parallel_reduce: 안쪽을 기다리는 동안 같은 worker 가 바깥 조각을 대신 실행해도
+		// 바깥 slot 의 부분 결과가 덮어써지지 않아야 한다.
+		auto add = [](uint64_t a, uint64_t b) { return a + b; };
+		const uint64_t nestedSum = ThreadPool::parallel_reduce(pool, { 0, 64 }, 1, uint64_t(0),
+			[&](ThreadPool::Range sub, uint64_t acc) {
+				for (size_t i = sub.begin; i < sub.end; ++i) {
+					acc += ThreadPool::parallel_reduce(pool, { 0, 1000 }, 10, uint64_t(0),
+						[](ThreadPool::Range inner, uint64_t x) { return x + inner.Size(); }, add);
+				}
+				return acc;
+			}, add);
+
+		std::cout << std::format("{:>12}: nested await sum: {} ({}), fib(20): {} ({}), nested parallel_for: {} ({}), nested reduce: {} ({})\n",
+			mode == ThreadPool::SchedulingMode::GlobalQueue ? "GlobalQueue" : "WorkStealing",
+			sum, sum == 288 ? "OK" : "FAIL", fib20, fib20 == 6765 ? "OK" : "FAIL",
+			nested.load(), nested == 6000 ? "OK" : "FAIL", nestedSum, nestedSum == 64'000 ? "OK" : "FAIL");
+	}
+
+	// TaskGroup 재귀로 나누는 quicksort.
+	{
+		constexpr size_t count = 4'000'000;
+		constexpr size_t cutoff = 16 * 1024;
+		std::vector<int> data(count);
+		std::mt19937 rng(7);
+		for (auto& v : data) v = static_cast<int>(rng());
+		std::vector<int> expected = data;
+
+		auto stp = clock::now();
+		std::sort(expected.begin(), expected.end());
+		const double sortMs = elapsedMs(stp);
+
+		ThreadPool::ThreadPool pool(3, ThreadPool::SchedulingMode::WorkStealing);
+		std::function<void(int*, int*)> quickSort = [&](int* first, int* last) {
+			if (last - first <= static_cast<ptrdiff_t>(cutoff)) {
+				std::sort(first, last);
 				return;
-			}			
-			std::function<void()> job = std::move(m_jobs.front());
-			m_jobs.pop();
-			lock.unlock();
-						
-			job();
+			}
+			const int mid = first[(last - first) / 2];
+			const int pivot = std::max(std::min(first[0], mid), std::min(std::max(first[0], mid), last[-1])); // median of 3
+			int* middle1 = std::partition(first, last, [pivot](int v) { return v < pivot; });
+			int* middle2 = std::partition(middle1, last, [pivot](int v) { return v == pivot; });
+			// 왼쪽은 다른 worker 에게 맡기고 오른쪽은 직접 계속한다.
+			ThreadPool::TaskGroup group(pool);
+			group.Run([&quickSort, first, middle1]() { quickSort(first, middle1); });
+			quickSort(middle2, last);
+			group.Wait();
+		};
+
+		stp = clock::now();
+		pool.Await(pool.EnqueueJob([&]() { quickSort(data.data(), data.data() + data.size()); }));
+		const double parallelMs = elapsedMs(stp);
+		std::cout << std::format("quicksort {} ints: std::sort {:.1f} ms, TaskGroup(3 workers) {:.1f} ms ({})\n",
+			count, sortMs, parallelMs, data == expected ? "OK" : "FAIL");
+	}
+}
+
+namespace bench_stealing
+{
+	// 수백 ns 정도 걸리는 짧은 작업.
+	uint64_t ShortWork(uint64_t x)
+	{
+		for (int i = 0; i < 64; ++i) {
+			x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		}
+		return x;
+	}
+
+	// 외부 쓰레드가 root 작업을 넣고, 각 root 가 worker 안에서 child 작업을 넣는다.
+	// (GlobalQueue 는 모든 push/pop 이 같은 mutex 를 잡고, WorkStealing 은 대부분 자기 deque 만 사용)
+	double MeasureJobsPerSec(size_t numThread, const ThreadPool::ThreadPoolOptions& options,
+		size_t numRoots, size_t numChildren)
+	{
+		ThreadPool::ThreadPool pool(numThread, options);
+
+		const size_t numJobs = numRoots * (numChildren + 1);
+		std::atomic<size_t> remaining{ numJobs };
+		std::atomic<uint64_t> sink{ 0 };
+		std::promise<void> done;
+		std::future<void> doneFuture = done.get_future();
+		auto finish = [&]() {
+			if (remaining.fetch_sub(1) == 1) done.set_value();
+		};
+
+		auto stp = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < numRoots; ++r) {
+			pool.EnqueueJob([&, r]() {
+				for (size_t c = 0; c < numChildren; ++c) {
+					pool.EnqueueJob([&, r, c]() {
+						sink.fetch_add(ShortWork(r * numChildren + c + 1), std::memory_order_relaxed);
+						finish();
+					});
+				}
+				finish();
+			});
+		}
+		doneFuture.wait();
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - stp).count();
+		return numJobs / elapsed;
+	}
+
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
+
+		constexpr size_t numRoots = 1000;
+		constexpr size_t numChildren = 100;
+		std::cout << std::format("jobs: {}, hardware_concurrency: {}\n",
+			numRoots * (numChildren + 1), std::thread::hardware_concurrency());
+		std::cout << std::format("{:>8} {:>16} {:>16} {:>8}\n", "threads", "global(jobs/s)", "stealing(jobs/s)", "ratio");
+
+		for (size_t numThread = 1; numThread <= 64; numThread *= 2) {
+			double global = MeasureJobsPerSec(numThread, { ThreadPool::SchedulingMode::GlobalQueue }, numRoots, numChildren);
+			double stealing = MeasureJobsPerSec(numThread, { ThreadPool::SchedulingMode::WorkStealing }, numRoots, numChildren);
+			std::cout << std::format("{:>8} {:>16.0f} {:>16.0f} {:>8.2f}\n", numThread, global, stealing, stealing / global);
 		}
 	}
+}
 
-	template <class F, class... Args>
-	std::future<std::invoke_result_t<F, Args...>>
-		ThreadPool::EnqueueJob(F&& f, Args&&... args)
+// worker 배치(Placement) 별 memory-bound 작업의 시간과 cache miss.
+// - 매 round 외부 쓰레드가 worker 수의 배수만큼 chunk 를 넣으므로, WorkStealing 의 round-robin 분배로
+//   chunk 는 매번 같은 worker queue 에 들어간다. worker 가 CPU 에 고정되어 있으면 지난 round 의
+//   데이터가 그 CPU 의 cache 에 남아 있고, OS 가 옮기면 다시 읽어 와야 한다.
+namespace bench_affinity
+{
+	void Run()
 	{
-		if (m_stopAll) {
-			throw std::runtime_error("ThreadPool 사용 중지됨");
+		std::cout << __func__ << std::endl;
+
+		const auto topology = ThreadPool::CpuTopology::Detect();
+		const size_t numThread = topology.Cpus().size();
+		std::cout << std::format("cpus: {}, packages: {}, L3 domains: {}, L3: {} KB\n",
+			numThread, topology.NumPackages(), topology.NumL3Domains(), topology.L3SizeBytes() / 1024);
+
+		constexpr size_t chunkBytes = 256 * 1024;
+		constexpr int rounds = 20;
+		const size_t numChunks = numThread * 4;
+		const size_t chunkSize = chunkBytes / sizeof(uint64_t);
+		std::vector<uint64_t> data(numChunks * chunkSize);
+		std::iota(data.begin(), data.end(), uint64_t(0));
+
+		benchmark::Options options;
+		options.maxRuns = 15;
+		for (auto [name, placement] : { std::pair{ "none", ThreadPool::Placement::None },
+			std::pair{ "compact", ThreadPool::Placement::Compact }, std::pair{ "spread", ThreadPool::Placement::Spread } })
+		{
+			ThreadPool::ThreadPool pool(numThread, { ThreadPool::SchedulingMode::WorkStealing, placement });
+			std::atomic<uint64_t> sink{ 0 };
+
+			// 일은 측정 전에 만든 worker 들이 하므로 counter 도 worker 쓰레드에서 센다.
+			options.threadIds.clear();
+			for (size_t i = 0; i < numThread; ++i) {
+				while (pool.GetWorkerThreadId(i) == 0) std::this_thread::yield();
+				options.threadIds.push_back(pool.GetWorkerThreadId(i));
+			}
+
+			auto result = benchmark::Run(std::format("affinity/{}", name), [&]() {
+				for (int r = 0; r < rounds; ++r) {
+					ThreadPool::WaitGroup done(numChunks);
+					for (size_t c = 0; c < numChunks; ++c) {
+						pool.Post([&, c]() {
+							const uint64_t* chunk = data.data() + c * chunkSize;
+							uint64_t sum = 0;
+							for (size_t i = 0; i < chunkSize; ++i) sum += chunk[i];
+							sink.fetch_add(sum, std::memory_order_relaxed);
+							done.Done();
+						});
+					}
+					done.Wait();
+				}
+			}, options);
+
+			std::string cpus;
+			for (size_t i = 0; i < numThread && i < 16; ++i)
+				cpus += std::format("{} ", pool.GetWorkerCpu(i));
+			std::cout << std::format("worker cpus: {}{}\n", cpus, numThread > 16 ? "..." : "");
+			benchmark::Print(result);
 		}
+	}
+}
+
+// 작업이 띄엄띄엄 들어올 때 idle 방식별 wake-up 지연과 CPU 사용량.
+// - 지연: Post 직전 ~ 작업 시작. park 는 futex wake + 스케줄링 비용이 그대로 보인다.
+// - CPU 사용량: 프로세스 CPU 시간 / 벽시계 시간. (1.0 = core 하나를 계속 사용)
+//   작업 자체는 거의 비어 있으므로 대부분 기다리는 비용이다. (Post 하는 쓰레드의 busy-wait 1.0 포함)
+namespace bench_idle
+{
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
+		using clock = std::chrono::steady_clock;
 
-		using ReturnType = std::invoke_result_t<F, Args...>;
-		auto job = std::make_shared<std::packaged_task<ReturnType()>>(
-			std::bind(f, std::forward<Args>(args)...));
+		constexpr size_t numThread = 4;
+		constexpr int numJobs = 2000;
+		constexpr auto gap = std::chrono::microseconds(50);
 
-		std::future<ReturnType> job_result_future = job->get_future();
+		for (auto [name, idle] : {
+			std::pair{ "park", ThreadPool::IdlePolicy::Park() },
+			std::pair{ "spin 20us", ThreadPool::IdlePolicy::Spin(std::chrono::microseconds(20)) },
+			std::pair{ "spin 100us", ThreadPool::IdlePolicy::Spin(std::chrono::microseconds(100)) },
+			std::pair{ "spin 20us + yield", ThreadPool::IdlePolicy::Spin(std::chrono::microseconds(20), 64) },
+			std::pair{ "adaptive 100us", ThreadPool::IdlePolicy::Adaptive(std::chrono::microseconds(100)) } })
 		{
-			std::lock_guard<std::mutex> lock(m_mutexForJobs);
-			m_jobs.push([job]() { (*job)(); });
+			for (auto mode : { ThreadPool::SchedulingMode::GlobalQueue, ThreadPool::SchedulingMode::WorkStealing })
+			{
+				ThreadPool::ThreadPoolOptions options;
+				options.mode = mode;
+				options.idle = idle;
+				ThreadPool::ThreadPool pool(numThread, options);
+				ThreadPool::AtomicHistogram latency; // 작업이 하나씩만 돌므로 기록하는 쓰레드도 한 번에 하나.
+				std::this_thread::sleep_for(std::chrono::milliseconds(10)); // worker 들이 대기 상태에 들어가도록
+
+				const double cpuBegin = benchmark::ProcessCpuSeconds();
+				const auto wallBegin = clock::now();
+				for (int i = 0; i < numJobs; ++i) {
+					ThreadPool::WaitGroup done(1);
+					const auto posted = clock::now();
+					pool.Post([&, posted]() {
+						latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - posted).count());
+						done.Done();
+					});
+					done.Wait();
+					// sleep 은 자신도 park 되어 지연이 섞이므로 busy-wait
+					for (const auto until = clock::now() + gap; clock::now() < until;) {}
+				}
+				const double wallSec = std::chrono::duration<double>(clock::now() - wallBegin).count();
+				const double cpuSec = benchmark::ProcessCpuSeconds() - cpuBegin;
+
+				const auto snapshot = latency.Snapshot();
+				std::cout << std::format("{:>18} {:>12}: wake p50 {:>6} ns, p99 {:>7} ns, cpu {:.2f} cores\n",
+					name, mode == ThreadPool::SchedulingMode::GlobalQueue ? "global" : "stealing",
+					snapshot.Percentile(0.5), snapshot.Percentile(0.99), wallSec > 0 ? cpuSec / wallSec : 0.0);
+			}
 		}
-		m_cvForJobs.notify_one();
+	}
+}
 
-		return job_result_future;
+// Snapshot() 으로 실행 중인 pool 의 상태를 읽는다.
+// 그리고 worker 통계의 비용: bench_stealing 의 짧은 작업(수백 ns) 처리량을 통계 on/off 로 비교.
+// (작업이 짧을수록 작업당 고정 비용이 크게 보이므로 가장 불리한 경우)
+// 실행할수록 느려지거나 빨라지는 흐름(drift) 이 차이보다 클 수 있어서 on/off 를 번갈아 실행하고 짝마다 비율의 median 을 본다.
+namespace bench_stats
+{
+	void PrintStats(const ThreadPool::ThreadPoolStats& stats)
+	{
+		std::cout << std::format("  jobs: {}, utilization: {:.1f}%, queued: {}/{}/{}, wait p99: <={} ns\n",
+			stats.TotalJobsExecuted(), stats.Utilization() * 100,
+			stats.queuedJobs[0], stats.queuedJobs[1], stats.queuedJobs[2], stats.queueWait[1].Percentile(0.99));
+		for (size_t i = 0; i < stats.workers.size(); ++i) {
+			const auto& w = stats.workers[i];
+			std::cout << std::format("  worker {}: jobs: {:>7}, steals: {:>6}, parks: {:>5}, busy: {:>5} ms, idle: {:>5} ms, depth: {}\n",
+				i, w.jobsExecuted, w.steals, w.parks,
+				std::chrono::duration_cast<std::chrono::milliseconds>(w.busyTime).count(),
+				std::chrono::duration_cast<std::chrono::milliseconds>(w.idleTime).count(), w.queueDepth);
+		}
 	}
 
-}  // namespace ThreadPool
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
 
-int work(int t, int id) 
+		// 실행 중에 읽기
+		{
+			ThreadPool::ThreadPool pool(4, ThreadPool::SchedulingMode::WorkStealing);
+			pool.EnableQueueWaitMetrics(true);
+			std::atomic<uint64_t> sink{ 0 };
+			ThreadPool::WaitGroup done(200'000);
+			for (size_t i = 0; i < 200'000; ++i) {
+				pool.Post([&, i]() {
+					sink.fetch_add(bench_stealing::ShortWork(i + 1), std::memory_order_relaxed);
+					done.Done();
+				});
+			}
+			std::cout << "while running:\n";
+			PrintStats(pool.Snapshot());
+			done.Wait();
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			std::cout << "after 20 ms idle:\n";
+			PrintStats(pool.Snapshot());
+		}
+
+		// 비용
+		constexpr size_t numRoots = 1000;
+		constexpr size_t numChildren = 100;
+		constexpr size_t numThread = 4;
+		constexpr int numPairs = 15;
+		for (auto mode : { ThreadPool::SchedulingMode::GlobalQueue, ThreadPool::SchedulingMode::WorkStealing })
+		{
+			auto measure = [&](bool workerStats) {
+				ThreadPool::ThreadPoolOptions poolOptions;
+				poolOptions.mode = mode;
+				poolOptions.workerStats = workerStats;
+				return bench_stealing::MeasureJobsPerSec(numThread, poolOptions, numRoots, numChildren);
+			};
+			measure(false); // warmup
+			std::vector<double> ratios;
+			double off = 0, on = 0;
+			for (int i = 0; i < numPairs; ++i) {
+				// 순서에 따른 치우침도 없도록 짝 안의 순서도 번갈아 바꾼다.
+				if (i % 2 == 0) { off = measure(false); on = measure(true); }
+				else { on = measure(true); off = measure(false); }
+				ratios.push_back(off / on);
+			}
+			std::sort(ratios.begin(), ratios.end());
+			std::cout << std::format("stats overhead {}: median {:+.2f}% (min {:+.2f}%, max {:+.2f}%, {} pairs)\n",
+				mode == ThreadPool::SchedulingMode::GlobalQueue ? "global  " : "stealing",
+				(ratios[numPairs / 2] - 1) * 100, (ratios.front() - 1) * 100, (ratios.back() - 1) * 100, numPairs);
+		}
+	}
+}
+
+// 10k 개 작업 제출: 하나씩(EnqueueJob + future, Post + WaitGroup) vs EnqueueBulk.
+// - submit: 제출 호출이 끝날 때까지 (제출하는 쓰레드가 lock / notify 에 쓰는 시간)
+// - total : 모든 작업이 끝날 때까지
+namespace bench_bulk
 {
-	printf("%d start \n", id);
-	std::this_thread::sleep_for(std::chrono::seconds(t));
-	printf("%d end after %ds\n", id, t);
-	return id;
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
+		using clock = std::chrono::steady_clock;
+
+		constexpr size_t numThread = 4;
+		constexpr size_t numJobs = 10'000;
+		constexpr int rounds = 30;
+
+		for (auto mode : { ThreadPool::SchedulingMode::GlobalQueue, ThreadPool::SchedulingMode::WorkStealing })
+		{
+			ThreadPool::ThreadPool pool(numThread, mode);
+			std::atomic<uint64_t> sink{ 0 };
+			auto makeTask = [&](size_t i) {
+				return [&sink, i]() { sink.fetch_add(bench_stealing::ShortWork(i + 1), std::memory_order_relaxed); };
+			};
+
+			// submit 과 total 의 median (us)
+			auto measure = [&](const char* name, auto&& submitAndWait) {
+				std::vector<double> submitUs, totalUs;
+				for (int r = 0; r < rounds; ++r) {
+					const auto stp = clock::now();
+					clock::time_point submitted;
+					submitAndWait(submitted);
+					const auto end = clock::now();
+					submitUs.push_back(std::chrono::duration<double, std::micro>(submitted - stp).count());
+					totalUs.push_back(std::chrono::duration<double, std::micro>(end - stp).count());
+				}
+				std::sort(submitUs.begin(), submitUs.end());
+				std::sort(totalUs.begin(), totalUs.end());
+				const double submit = submitUs[rounds / 2];
+				std::cout << std::format("{:>8} {:<22}: submit {:>8.1f} us ({:>6.1f} M jobs/s), total {:>8.1f} us\n",
+					mode == ThreadPool::SchedulingMode::GlobalQueue ? "global" : "stealing", name,
+					submit, numJobs / submit, totalUs[rounds / 2]);
+			};
+
+			measure("EnqueueJob + future", [&](clock::time_point& submitted) {
+				std::vector<std::future<void>> futures;
+				futures.reserve(numJobs);
+				for (size_t i = 0; i < numJobs; ++i) futures.push_back(pool.EnqueueJob(makeTask(i)));
+				submitted = clock::now();
+				for (auto& f : futures) f.get();
+			});
+
+			measure("Post + WaitGroup", [&](clock::time_point& submitted) {
+				ThreadPool::WaitGroup done(numJobs);
+				for (size_t i = 0; i < numJobs; ++i) {
+					pool.Post([&, task = makeTask(i)]() { task(); done.Done(); });
+				}
+				submitted = clock::now();
+				done.Wait();
+			});
+
+			std::vector<decltype(makeTask(0))> tasks;
+			tasks.reserve(numJobs);
+			measure("EnqueueBulk", [&](clock::time_point& submitted) {
+				tasks.clear();
+				for (size_t i = 0; i < numJobs; ++i) tasks.push_back(makeTask(i));
+				auto handle = pool.EnqueueBulk(std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+				submitted = clock::now();
+				handle.Get();
+			});
+		}
+	}
 }
 
-int main() 
+// TimerWheel 의 등록 / 취소 비용이 타이머 수와 무관한지, 그리고 만료 후 실행까지의 지연.
+namespace bench_timers
 {
-	ThreadPool::ThreadPool pool(3);
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
+		using clock = std::chrono::steady_clock;
+		using namespace std::chrono_literals;
 
-	std::vector<std::future<int>> futures;
-	for (int i = 0; i < 10; i++) {
-		futures.emplace_back(pool.EnqueueJob(work, i % 3 + 1, i));
+		std::mt19937_64 rng(42);
+
+		// 1M 개 등록 후 무작위 순서로 모두 취소. (1~60 초 뒤에 만료될 타이머라 실행되지는 않음)
+		{
+			ThreadPool::TimerWheel wheel;
+			std::uniform_int_distribution<int64_t> delayMs(1'000, 60'000);
+			for (size_t numTimers : { size_t(10'000), size_t(100'000), size_t(1'000'000) }) {
+				std::vector<ThreadPool::TimerId> ids;
+				ids.reserve(numTimers);
+				auto stp = clock::now();
+				for (size_t i = 0; i < numTimers; ++i)
+					ids.push_back(wheel.Schedule(std::chrono::milliseconds(delayMs(rng)), []() {}));
+				const double insertNs = std::chrono::duration<double, std::nano>(clock::now() - stp).count() / numTimers;
+				const size_t outstanding = wheel.Size();
+
+				std::shuffle(ids.begin(), ids.end(), rng);
+				size_t numCancelled = 0;
+				stp = clock::now();
+				for (auto id : ids) numCancelled += wheel.Cancel(id);
+				const double cancelNs = std::chrono::duration<double, std::nano>(clock::now() - stp).count() / numTimers;
+
+				std::cout << std::format("{:>8} timers: insert {:>6.1f} ns, cancel {:>6.1f} ns, outstanding {}, cancelled {}\n",
+					numTimers, insertNs, cancelNs, outstanding, numCancelled);
+			}
+		}
+
+		// 만료 ~ pool 에서 실행 시작까지의 지연 (resolution 1ms 이므로 0~1ms + 깨어나는 시간 + queue)
+		{
+			ThreadPool::ThreadPool pool(4);
+			constexpr size_t numTimers = 10'000;
+			std::uniform_int_distribution<int64_t> delayUs(1'000, 200'000);
+			ThreadPool::AtomicHistogram lateness[4]; // worker 별 (쓰는 쓰레드 하나씩)
+			ThreadPool::WaitGroup done(numTimers);
+			for (size_t i = 0; i < numTimers; ++i) {
+				const auto delay = std::chrono::microseconds(delayUs(rng));
+				const auto due = clock::now() + delay;
+				pool.EnqueueAfter(delay, [&, due]() {
+					const auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - due).count();
+					lateness[pool.GetCurrentWorkerIndex()].Record(late > 0 ? late : 0);
+					done.Done();
+				});
+			}
+			done.Wait();
+			ThreadPool::Histogram total;
+			for (auto& histogram : lateness) total.Merge(histogram.Snapshot());
+			std::cout << std::format("lateness ({} timers, 1ms resolution): p50 <={} us, p99 <={} us, max {} us\n",
+				total.Count(), total.Percentile(0.5) / 1000, total.Percentile(0.99) / 1000, total.Max() / 1000);
+		}
 	}
-	for (auto& f : futures) {
-		printf("result : %d \n", f.get());
+}
+
+// std::mutex vs FutexMutex: 짧은 임계 구역을 여러 쓰레드가 번갈아 잡을 때 lock 당 시간과 경합 통계.
+// 그리고 WorkStealing pool 을 돌린 뒤 HottestLocks() 로 pool 내부 lock(WorkerQueue, BlockPool) 중 어디서 기다렸는지 본다.
+namespace bench_locks
+{
+	template <class Mutex>
+	double MeasureNsPerLock(Mutex& mutex, size_t numThreads, size_t locksPerThread)
+	{
+		uint64_t shared = 0;
+		std::latch start(numThreads + 1);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < numThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				start.arrive_and_wait();
+				uint64_t x = t + 1;
+				for (size_t i = 0; i < locksPerThread; ++i) {
+					{
+						std::lock_guard<Mutex> lock(mutex);
+						shared += x;
+					}
+					x = bench_stealing::ShortWork(x) & 0xff; // lock 밖의 일
+				}
+			});
+		}
+		start.arrive_and_wait();
+		auto stp = std::chrono::steady_clock::now();
+		for (auto& t : threads) t.join();
+		const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - stp).count();
+		return elapsed / (numThreads * locksPerThread);
+	}
+
+	void PrintLockStats(const ThreadPool::LockStats& stats)
+	{
+		std::cout << std::format("  {:<16} acquisitions: {:>9}, contended: {:>7} ({:5.2f}%), wait: {:>7.2f} ms\n",
+			stats.name, stats.acquisitions, stats.contended, stats.ContendedRatio() * 100,
+			std::chrono::duration<double, std::milli>(stats.waitTime).count());
+	}
+
+	void Run()
+	{
+		std::cout << __func__ << std::endl;
+
+		constexpr size_t locksPerThread = 200'000;
+		for (size_t numThreads : { 1, 2, 4, 8 }) {
+			std::mutex stdMutex;
+			ThreadPool::FutexMutex futexMutex("bench");
+			const double stdNs = MeasureNsPerLock(stdMutex, numThreads, locksPerThread);
+			const double futexNs = MeasureNsPerLock(futexMutex, numThreads, locksPerThread);
+			std::cout << std::format("threads {}: std::mutex {:6.1f} ns/lock, FutexMutex {:6.1f} ns/lock\n",
+				numThreads, stdNs, futexNs);
+			PrintLockStats(futexMutex.Stats());
+		}
+
+		// pool 내부 lock 중 가장 오래 기다린 것. (pool 이 살아 있는 동안 읽는다: 파괴되면 목록에서 빠짐)
+		{
+			ThreadPool::ThreadPool pool(4, ThreadPool::SchedulingMode::WorkStealing);
+			std::atomic<uint64_t> sink{ 0 };
+			ThreadPool::WaitGroup done(1000 * 100);
+			for (size_t r = 0; r < 1000; ++r) {
+				pool.Post([&, r]() {
+					for (size_t c = 0; c < 100; ++c) {
+						pool.Post([&, r, c]() {
+							sink.fetch_add(bench_stealing::ShortWork(r * 100 + c + 1), std::memory_order_relaxed);
+							done.Done();
+						});
+					}
+				});
+			}
+			done.Wait();
+			std::cout << "hottest locks:\n";
+			for (const auto& stats : ThreadPool::HottestLocks(6))
+				PrintLockStats(stats);
+		}
 	}
 }
+
+int main() 
+{
+	auto PrintSplitLines = []() {std::cout << std::format("{:-<{}}\n", "", 50); };
+
+	PrintSplitLines();
+	Test1_Basic();
+
+	PrintSplitLines();
+	Test2_AllocationFreeSubmit();
+
+	PrintSplitLines();
+	Test3_ParallelFor();
+
+	PrintSplitLines();
+	Test4_TaskGraph();
+
+	PrintSplitLines();
+	Test5_PriorityLanes();
+
+	PrintSplitLines();
+	Test6_Cancellation();
+
+	PrintSplitLines();
+	Test7_Timers();
+
+	PrintSplitLines();
+	Test8_HelpWhileWaiting();
+
+	PrintSplitLines();
+	bench_stealing::Run();
+
+	PrintSplitLines();
+	bench_affinity::Run();
+
+	PrintSplitLines();
+	bench_idle::Run();
+
+	PrintSplitLines();
+	bench_stats::Run();
+
+	PrintSplitLines();
+	bench_bulk::Run();
+
+	PrintSplitLines();
+	bench_timers::Run();
+
+	PrintSplitLines();
+	bench_locks::Run();
+}
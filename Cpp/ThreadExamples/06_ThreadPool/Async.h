@@ -0,0 +1,173 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "PoolAllocator.h"
+#include "ThreadPool.h"
+
+namespace ThreadPool
+{
+	// async 의 실행 방식.
+	enum class Launch
+	{
+		Async,    // pool 에 넣는다. worker 가 꺼내기 전에 get()/wait() 하면 호출한 쓰레드가 직접 실행.
+		Deferred, // pool 에 넣지 않고 get()/wait() 에서 실행. (바로 기다릴 작업: 넘기고 깨우는 비용이 없음)
+	};
+
+	// async(f, args...) 가 쓰는 공용 pool. 처음 쓸 때 만들어진다. (worker: hardware_concurrency 개)
+	inline ThreadPool& DefaultPool()
+	{
+		static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u), SchedulingMode::WorkStealing);
+		return pool;
+	}
+
+	template <class R> class AsyncFuture;
+
+	namespace detail
+	{
+		template <class R>
+		struct AsyncValue { std::optional<R> value; };
+		template <>
+		struct AsyncValue<void> {};
+
+		// async 한 번의 상태. worker 와 get() 하는 쪽 중 먼저 stage 를 차지한 쪽이 실행한다.
+		// 완료는 atomic wait/notify 로 알린다. (mutex / condition_variable 없음)
+		template <class R>
+		struct AsyncStateBase : AsyncValue<R>
+		{
+			enum Stage : uint8_t { kPending, kRunning, kReady };
+			std::atomic<uint8_t> stage{ kPending };
+			std::exception_ptr exception;
+
+			virtual ~AsyncStateBase() = default;
+			virtual void Invoke() = 0; // 결과를 value / exception 에 기록
+
+			// 아직 아무도 실행하지 않았으면 현재 쓰레드에서 실행한다.
+			bool TryRun()
+			{
+				uint8_t expected = kPending;
+				if (!stage.compare_exchange_strong(expected, kRunning, std::memory_order_acquire, std::memory_order_relaxed))
+					return false;
+				Invoke();
+				stage.store(kReady, std::memory_order_release);
+				stage.notify_all();
+				return true;
+			}
+
+			bool IsReady() const { return stage.load(std::memory_order_acquire) == kReady; }
+		};
+
+		template <class R, class Call>
+		struct AsyncState final : AsyncStateBase<R>
+		{
+			Call call;
+
+			explicit AsyncState(Call&& c) : call(std::move(c)) {}
+
+			void Invoke() override
+			{
+				try {
+					if constexpr (std::is_void_v<R>)
+						call();
+					else
+						this->value.emplace(call());
+				}
+				catch (...) {
+					this->exception = std::current_exception();
+				}
+			}
+		};
+	}
+
+	// async 의 결과.
+	// - get()/wait() 때 작업이 아직 queue 에 있으면 기다리지 않고 직접 실행한다.
+	// - 이미 다른 쓰레드가 실행 중이면 기다린다. (pool 의 worker 이면 그동안 다른 작업을 실행)
+	// - std::async 와 달리 소멸자는 기다리지 않는다. (Launch::Async 작업은 worker 가 마저 실행)
+	template <class R>
+	class AsyncFuture
+	{
+	public:
+		AsyncFuture() = default;
+		AsyncFuture(AsyncFuture&&) noexcept = default;
+		AsyncFuture& operator=(AsyncFuture&&) noexcept = default;
+
+		bool valid() const { return m_state != nullptr; }
+		bool is_ready() const { return m_state->IsReady(); }
+
+		void wait() const
+		{
+			if (m_state->TryRun())
+				return;
+			if (m_pool->GetCurrentWorkerIndex() != ThreadPool::kNotWorker) {
+				m_pool->HelpUntil([this]() { return m_state->IsReady(); });
+				return;
+			}
+			uint8_t stage;
+			while ((stage = m_state->stage.load(std::memory_order_acquire)) != detail::AsyncStateBase<R>::kReady)
+				m_state->stage.wait(stage, std::memory_order_acquire);
+		}
+
+		// 결과를 꺼낸다. (future 는 더 이상 유효하지 않음)
+		R get()
+		{
+			wait();
+			auto state = std::move(m_state);
+			if (state->exception)
+				std::rethrow_exception(state->exception);
+			if constexpr (!std::is_void_v<R>)
+				return std::move(*state->value);
+		}
+
+	private:
+		template <class F, class... Args>
+		friend auto async(Launch policy, ThreadPool& executor, F&& f, Args&&... args);
+
+		AsyncFuture(std::shared_ptr<detail::AsyncStateBase<R>> state, ThreadPool* pool)
+			: m_state(std::move(state)), m_pool(pool) {}
+
+		std::shared_ptr<detail::AsyncStateBase<R>> m_state;
+		ThreadPool* m_pool{ nullptr };
+	};
+
+	// std::async 대신 executor(pool) 에서 실행한다. (호출마다 쓰레드를 만들지 않음)
+	// f 와 args 는 std::async 처럼 복사(또는 move) 해서 보관한다.
+	template <class F, class... Args>
+	auto async(Launch policy, ThreadPool& executor, F&& f, Args&&... args)
+	{
+		using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+		auto call = [f = std::forward<F>(f), ...args = std::forward<Args>(args)]() mutable -> R {
+			return std::invoke(std::move(f), std::move(args)...);
+		};
+		using State = detail::AsyncState<R, decltype(call)>;
+		std::shared_ptr<detail::AsyncStateBase<R>> state =
+			std::allocate_shared<State>(PoolAllocator<State>(), std::move(call));
+
+		// Job 은 shared_ptr 하나만 들고 간다. (내부 버퍼에 들어감)
+		if (policy == Launch::Async)
+			executor.Post([state]() { state->TryRun(); });
+		return AsyncFuture<R>(std::move(state), &executor);
+	}
+
+	template <class F, class... Args>
+	auto async(ThreadPool& executor, F&& f, Args&&... args)
+	{
+		return async(Launch::Async, executor, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+	template <class F, class... Args>
+		requires (!std::is_same_v<std::remove_cvref_t<F>, ThreadPool> && !std::is_same_v<std::remove_cvref_t<F>, Launch>)
+	auto async(F&& f, Args&&... args)
+	{
+		return async(Launch::Async, DefaultPool(), std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+}  // namespace ThreadPool
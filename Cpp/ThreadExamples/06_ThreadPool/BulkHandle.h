@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#include "WaitGroup.h"
+
+namespace ThreadPool
+{
+	namespace detail
+	{
+		// EnqueueBulk 한 번이 공유하는 상태.
+		// 작업들은 포인터만 들고 가고, BulkHandle 이 모두 끝날 때까지 살려 둔다.
+		struct BulkState
+		{
+			WaitGroup waitGroup{ 1 }; // 제출하는 쪽 몫 1 (0 개 제출도 끝나도록)
+			size_t size{ 0 };
+
+			std::mutex exceptionMutex;
+			std::exception_ptr exception;
+
+			void SetException(std::exception_ptr e)
+			{
+				std::lock_guard<std::mutex> lock(exceptionMutex);
+				if (!exception)
+					exception = std::move(e);
+			}
+		};
+	}
+
+	// EnqueueBulk 으로 넣은 작업 묶음의 완료 handle. (작업마다 future 를 두는 대신 latch 하나)
+	// - 소멸자는 묶음이 모두 끝날 때까지 기다린다. (작업들이 공유 상태를 가리키고 있으므로)
+	// - worker 안에서 Wait 하면 묶음이 다른 worker 에 의해 처리될 때까지 그 worker 를 막는다.
+	class BulkHandle
+	{
+	public:
+		BulkHandle() = default;
+		explicit BulkHandle(std::unique_ptr<detail::BulkState> state) : m_state(std::move(state)) {}
+
+		BulkHandle(BulkHandle&&) noexcept = default;
+		BulkHandle& operator=(BulkHandle&& other) noexcept
+		{
+			if (this != &other) {
+				Wait();
+				m_state = std::move(other.m_state);
+			}
+			return *this;
+		}
+
+		~BulkHandle() { Wait(); }
+
+		size_t Size() const { return m_state ? m_state->size : 0; }
+
+		void Wait()
+		{
+			if (m_state)
+				m_state->waitGroup.Wait();
+		}
+
+		// 기다린 뒤, 실패(예외 / 취소) 한 작업이 있으면 처음 것을 다시 던진다.
+		void Get()
+		{
+			Wait();
+			if (m_state && m_state->exception)
+				std::rethrow_exception(m_state->exception);
+		}
+
+	private:
+		std::unique_ptr<detail::BulkState> m_state;
+	};
+
+}  // namespace ThreadPool
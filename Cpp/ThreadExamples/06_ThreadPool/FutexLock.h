@@ -0,0 +1,278 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SpinWait.h"
+
+namespace ThreadPool
+{
+	// lock 하나의 경합 통계.
+	struct LockStats
+	{
+		const char* name{ "" };
+		uint64_t acquisitions{ 0 };             // lock / Wait 성공 횟수
+		uint64_t contended{ 0 };                // 바로 얻지 못하고 기다린 횟수
+		std::chrono::nanoseconds waitTime{ 0 }; // 기다린 시간의 합
+
+		double ContendedRatio() const { return acquisitions ? static_cast<double>(contended) / acquisitions : 0.0; }
+	};
+
+	namespace detail
+	{
+		// CPU 가 하나면 잡고 있는 쓰레드가 실행되지 않는 동안이라 spin 해도 풀리지 않는다.
+		inline uint32_t EffectiveSpinCount(uint32_t spinCount)
+		{
+			static const bool singleCpu = std::thread::hardware_concurrency() <= 1;
+			return singleCpu ? 0 : spinCount;
+		}
+
+		class LockCounters;
+
+		// 이름 있는 lock 목록. 등록/해제와 HottestLocks() 에서만 잡는다.
+		struct LockRegistry
+		{
+			std::mutex mutex;
+			std::vector<const LockCounters*> locks;
+
+			static LockRegistry& Get()
+			{
+				static LockRegistry registry;
+				return registry;
+			}
+		};
+
+		// FutexMutex / AutoResetEvent 의 통계.
+		// - 이름을 주면 LockRegistry 에 등록되어 HottestLocks() 에 나온다.
+		// - 경합이 없으면 횟수만 올리고, 시각은 기다려야 할 때만 읽는다.
+		class LockCounters
+		{
+		public:
+			explicit LockCounters(const char* name) : m_name(name)
+			{
+				if (!m_name)
+					return;
+				auto& registry = LockRegistry::Get();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.locks.push_back(this);
+			}
+
+			~LockCounters()
+			{
+				if (!m_name)
+					return;
+				auto& registry = LockRegistry::Get();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				std::erase(registry.locks, this);
+			}
+
+			LockCounters(const LockCounters&) = delete;
+			LockCounters& operator=(const LockCounters&) = delete;
+
+			static int64_t NowNs()
+			{
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
+
+			// kExclusive: lock 을 잡은 채로 기록하므로 다른 쓰레드와 겹치지 않는다. (relaxed load + store)
+			template <bool kExclusive>
+			void Record(int64_t waitNs)
+			{
+				Add<kExclusive>(m_acquisitions, 1);
+				if (waitNs >= 0) {
+					Add<kExclusive>(m_contended, 1);
+					Add<kExclusive>(m_waitNs, static_cast<uint64_t>(waitNs));
+				}
+			}
+
+			LockStats Stats() const
+			{
+				return { m_name ? m_name : "",
+					m_acquisitions.load(std::memory_order_relaxed),
+					m_contended.load(std::memory_order_relaxed),
+					std::chrono::nanoseconds(m_waitNs.load(std::memory_order_relaxed)) };
+			}
+
+		private:
+			template <bool kExclusive>
+			static void Add(std::atomic<uint64_t>& counter, uint64_t value)
+			{
+				if constexpr (kExclusive)
+					counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+				else
+					counter.fetch_add(value, std::memory_order_relaxed);
+			}
+
+			const char* m_name;
+			std::atomic<uint64_t> m_acquisitions{ 0 };
+			std::atomic<uint64_t> m_contended{ 0 };
+			std::atomic<uint64_t> m_waitNs{ 0 };
+		};
+	}
+
+	// std::mutex 대신 쓰는 mutex. (lock_guard / unique_lock / condition_variable_any 와 함께 사용)
+	// - 상태 0: 풀림, 1: 잠김, 2: 잠김 + 잠든 쓰레드가 있을 수 있음. (Drepper, "Futexes Are Tricky" 의 mutex2)
+	// - 경합이 없으면 CAS 한 번으로 얻고, unlock 은 잠든 쓰레드가 없으면 exchange 한 번. (커널 호출 없음)
+	// - 잠겨 있으면 spinCount 번 pause 하며 풀리기를 기다린 뒤 std::atomic::wait 로 잠든다. (CPU 가 하나면 spin 생략)
+	//   (Linux: futex, Windows: WaitOnAddress)
+	// - 획득 횟수 / 경합 횟수 / 기다린 시간을 기록한다. (Stats, HottestLocks)
+	class FutexMutex
+	{
+	public:
+		static constexpr uint32_t kDefaultSpinCount = 100;
+
+		// name: HottestLocks() 에 표시할 이름. (nullptr 이면 등록하지 않음, 문자열은 lock 보다 오래 살아야 함)
+		explicit FutexMutex(const char* name = nullptr, uint32_t spinCount = kDefaultSpinCount)
+			: m_counters(name), m_spinCount(detail::EffectiveSpinCount(spinCount)) {}
+
+		FutexMutex(const FutexMutex&) = delete;
+		FutexMutex& operator=(const FutexMutex&) = delete;
+
+		void lock()
+		{
+			uint32_t expected = kUnlocked;
+			if (m_state.compare_exchange_strong(expected, kLocked, std::memory_order_acquire, std::memory_order_relaxed)) {
+				m_counters.Record<true>(-1);
+				return;
+			}
+			const int64_t stp = detail::LockCounters::NowNs();
+			LockContended();
+			m_counters.Record<true>(detail::LockCounters::NowNs() - stp);
+		}
+
+		bool try_lock()
+		{
+			uint32_t expected = kUnlocked;
+			if (!m_state.compare_exchange_strong(expected, kLocked, std::memory_order_acquire, std::memory_order_relaxed))
+				return false;
+			m_counters.Record<true>(-1);
+			return true;
+		}
+
+		void unlock()
+		{
+			if (m_state.exchange(kUnlocked, std::memory_order_release) == kLockedWithWaiters)
+				m_state.notify_one();
+		}
+
+		LockStats Stats() const { return m_counters.Stats(); }
+
+	private:
+		static constexpr uint32_t kUnlocked = 0;
+		static constexpr uint32_t kLocked = 1;
+		static constexpr uint32_t kLockedWithWaiters = 2;
+
+		void LockContended()
+		{
+			// 잠깐 spin: 임계 구역이 짧으면 잠들기 전에 풀린다.
+			for (uint32_t i = 0; i < m_spinCount; ++i) {
+				CpuRelax();
+				uint32_t expected = kUnlocked;
+				if (m_state.load(std::memory_order_relaxed) == kUnlocked &&
+					m_state.compare_exchange_weak(expected, kLocked, std::memory_order_acquire, std::memory_order_relaxed))
+					return;
+			}
+			// 잠들기 전에 2 로 바꿔 unlock 하는 쪽이 깨우게 한다.
+			// 여기서 얻으면 상태가 2 로 남으므로 unlock 이 notify 를 한 번 더 할 수 있다. (정확성에는 문제없음)
+			while (m_state.exchange(kLockedWithWaiters, std::memory_order_acquire) != kUnlocked)
+				m_state.wait(kLockedWithWaiters, std::memory_order_relaxed);
+		}
+
+		std::atomic<uint32_t> m_state{ kUnlocked };
+		detail::LockCounters m_counters;
+		uint32_t m_spinCount;
+	};
+
+	// 자동으로 닫히는 event. (Win32 auto-reset event 와 같은 의미)
+	// - Set() 은 신호를 켠다. 기다리는 쓰레드가 있으면 하나만 깨어나고 신호는 다시 꺼진다.
+	// - 아무도 기다리지 않을 때의 Set() 은 다음 Wait() 하나가 바로 통과하게 한다. (여러 번 Set 해도 하나로 합쳐짐)
+	// - 잠든 쓰레드가 없으면 Set() 은 notify(커널 호출) 를 생략한다.
+	// - condition_variable 과 달리 mutex 가 필요 없다. 대신 신호가 합쳐지므로, 여러 consumer 가 기다리는 queue 라면
+	//   깨어난 쪽이 남은 항목을 보고 다시 Set() 해 다음 consumer 를 깨워야 한다.
+	class AutoResetEvent
+	{
+	public:
+		static constexpr uint32_t kDefaultSpinCount = 100;
+
+		explicit AutoResetEvent(const char* name = nullptr, uint32_t spinCount = kDefaultSpinCount)
+			: m_counters(name), m_spinCount(detail::EffectiveSpinCount(spinCount)) {}
+
+		AutoResetEvent(const AutoResetEvent&) = delete;
+		AutoResetEvent& operator=(const AutoResetEvent&) = delete;
+
+		void Set()
+		{
+			// Wait 의 "waiters 증가 → signaled 확인" 과 엇갈려 둘 다 놓치지 않도록 seq_cst.
+			if (m_signaled.exchange(1, std::memory_order_seq_cst) == 0 && m_numWaiters.load(std::memory_order_seq_cst) > 0)
+				m_signaled.notify_one();
+		}
+
+		// 신호가 켜져 있으면 끄고 true.
+		bool TryWait()
+		{
+			if (m_signaled.load(std::memory_order_relaxed) == 0 || m_signaled.exchange(0, std::memory_order_acquire) == 0)
+				return false;
+			m_counters.Record<false>(-1);
+			return true;
+		}
+
+		void Wait()
+		{
+			if (m_signaled.exchange(0, std::memory_order_acquire) == 1) {
+				m_counters.Record<false>(-1);
+				return;
+			}
+			const int64_t stp = detail::LockCounters::NowNs();
+			WaitContended();
+			m_counters.Record<false>(detail::LockCounters::NowNs() - stp);
+		}
+
+		LockStats Stats() const { return m_counters.Stats(); }
+
+	private:
+		void WaitContended()
+		{
+			for (uint32_t i = 0; i < m_spinCount; ++i) {
+				CpuRelax();
+				if (m_signaled.load(std::memory_order_relaxed) == 1 && m_signaled.exchange(0, std::memory_order_acquire) == 1)
+					return;
+			}
+			m_numWaiters.fetch_add(1, std::memory_order_seq_cst);
+			while (m_signaled.exchange(0, std::memory_order_seq_cst) == 0)
+				m_signaled.wait(0, std::memory_order_relaxed);
+			m_numWaiters.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		std::atomic<uint32_t> m_signaled{ 0 };
+		std::atomic<uint32_t> m_numWaiters{ 0 };
+		detail::LockCounters m_counters;
+		uint32_t m_spinCount;
+	};
+
+	// 이름 있는 FutexMutex / AutoResetEvent 를 기다린 시간이 긴 순서로 최대 maxCount 개.
+	// (운영 중에 주기적으로 읽어 가장 뜨거운 lock 을 찾는 용도. 값은 lock 을 멈추지 않고 읽은 근사값)
+	inline std::vector<LockStats> HottestLocks(size_t maxCount = SIZE_MAX)
+	{
+		std::vector<LockStats> result;
+		{
+			auto& registry = detail::LockRegistry::Get();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			result.reserve(registry.locks.size());
+			for (const auto* counters : registry.locks)
+				result.push_back(counters->Stats());
+		}
+		std::sort(result.begin(), result.end(), [](const LockStats& a, const LockStats& b) {
+			return a.waitTime > b.waitTime;
+		});
+		if (result.size() > maxCount)
+			result.resize(maxCount);
+		return result;
+	}
+
+}  // namespace ThreadPool
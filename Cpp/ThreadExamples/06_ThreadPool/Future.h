@@ -0,0 +1,406 @@
+﻿#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Job.h"
+#include "PoolAllocator.h"
+
+namespace ThreadPool
+{
+	template <class T> class Future;
+	template <class T> class Promise;
+
+	namespace detail
+	{
+		template <class T>
+		struct FutureValue { std::optional<T> value; };
+		template <>
+		struct FutureValue<void> {};
+
+		// Promise / Future 가 공유하는 상태.
+		// - 완료되면 등록된 continuation 을 완료시킨 쓰레드에서 한 번 호출한다.
+		// - continuation 은 보통 executor 에 작업을 넣기만 하므로 짧다.
+		template <class T>
+		struct FutureState : FutureValue<T>
+		{
+			std::mutex mutex;
+			std::condition_variable cv; // 블로킹 get()/wait() 용
+			bool ready{ false };
+			std::exception_ptr exception;
+			Job continuation;
+
+			template <class Setter>
+			void Complete(Setter&& setter)
+			{
+				Job callback;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (ready) {
+						throw std::future_error(std::future_errc::promise_already_satisfied);
+					}
+					setter(*this);
+					ready = true;
+					callback = std::move(continuation);
+				}
+				cv.notify_all();
+				if (callback)
+					callback();
+			}
+
+			// 이미 완료되었으면 바로, 아니면 완료될 때 callback 을 호출.
+			void OnReady(Job&& callback)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					if (!ready) {
+						continuation = std::move(callback);
+						return;
+					}
+				}
+				callback();
+			}
+
+			// 아직 완료되지 않았다면 등록된 continuation 을 제거. (when_any 에서 사용)
+			void ClearContinuation()
+			{
+				Job callback;
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!ready)
+					callback = std::move(continuation);
+			}
+		};
+
+		template <class T>
+		std::shared_ptr<FutureState<T>> MakeFutureState()
+		{
+			return std::allocate_shared<FutureState<T>>(PoolAllocator<FutureState<T>>());
+		}
+
+		// f(value...) 를 실행해서 결과를 promise 에 넣는다.
+		template <class R, class F, class... Args>
+		void Fulfill(Promise<R>& promise, F& f, Args&&... args)
+		{
+			try {
+				if constexpr (std::is_void_v<R>) {
+					f(std::forward<Args>(args)...);
+					promise.set_value();
+				}
+				else {
+					promise.set_value(f(std::forward<Args>(args)...));
+				}
+			}
+			catch (...) {
+				promise.set_exception(std::current_exception());
+			}
+		}
+
+		// then() 이 executor 에 넣는 작업. 예외는 f 를 건너뛰고 그대로 전달.
+		template <class T, class R, class F>
+		struct ThenTask
+		{
+			std::shared_ptr<FutureState<T>> state;
+			Promise<R> promise;
+			F f;
+
+			void operator()()
+			{
+				if (state->exception) {
+					promise.set_exception(state->exception);
+				}
+				else if constexpr (std::is_void_v<T>) {
+					Fulfill(promise, f);
+				}
+				else {
+					Fulfill(promise, f, std::move(*state->value));
+				}
+			}
+		};
+	}
+
+	// then() 으로 continuation 을 이어 붙일 수 있는 future.
+	// - then(executor, f): 완료되면 f(value) 를 executor.Post() 로 실행하고 그 결과의 Future 를 돌려준다.
+	// - 기다리는 동안 어떤 쓰레드도 막히지 않는다. (get()/wait() 를 부르는 쓰레드만 예외)
+	template <class T>
+	class Future
+	{
+	public:
+		Future() = default;
+		Future(Future&&) noexcept = default;
+		Future& operator=(Future&&) noexcept = default;
+
+		bool valid() const { return m_state != nullptr; }
+
+		bool is_ready() const
+		{
+			std::lock_guard<std::mutex> lock(m_state->mutex);
+			return m_state->ready;
+		}
+
+		void wait() const
+		{
+			std::unique_lock<std::mutex> lock(m_state->mutex);
+			m_state->cv.wait(lock, [this]() { return m_state->ready; });
+		}
+
+		// 결과를 꺼낸다. (future 는 더 이상 유효하지 않음)
+		T get()
+		{
+			wait();
+			auto state = std::move(m_state);
+			if (state->exception)
+				std::rethrow_exception(state->exception);
+			if constexpr (!std::is_void_v<T>)
+				return std::move(*state->value);
+		}
+
+		template <class Executor, class F>
+		auto then(Executor& executor, F&& f) &&;
+
+		// 완료를 쓰레드를 막지 않고 알리는 내부 hook. (when_all / when_any 에서 사용)
+		template <class Callback>
+		void OnReady(Callback&& callback) { m_state->OnReady(Job(std::forward<Callback>(callback))); }
+
+		void ClearContinuation() { m_state->ClearContinuation(); }
+
+	private:
+		template <class> friend class Promise;
+
+		explicit Future(std::shared_ptr<detail::FutureState<T>> state) : m_state(std::move(state)) {}
+
+		std::shared_ptr<detail::FutureState<T>> m_state;
+	};
+
+	template <class T>
+	class Promise
+	{
+	public:
+		Promise() : m_state(detail::MakeFutureState<T>()) {}
+		Promise(Promise&&) noexcept = default;
+		Promise& operator=(Promise&& other) noexcept
+		{
+			Abandon();
+			m_state = std::move(other.m_state);
+			m_futureRetrieved = other.m_futureRetrieved;
+			m_satisfied = other.m_satisfied;
+			return *this;
+		}
+		~Promise() { Abandon(); }
+
+		Future<T> get_future()
+		{
+			if (m_futureRetrieved) {
+				throw std::future_error(std::future_errc::future_already_retrieved);
+			}
+			m_futureRetrieved = true;
+			return Future<T>(m_state);
+		}
+
+		template <class... U>
+		void set_value(U&&... value)
+		{
+			CheckState();
+			m_satisfied = true;
+			m_state->Complete([&](detail::FutureState<T>& state) {
+				if constexpr (!std::is_void_v<T>)
+					state.value.emplace(std::forward<U>(value)...);
+			});
+		}
+
+		void set_exception(std::exception_ptr exception)
+		{
+			CheckState();
+			m_satisfied = true;
+			m_state->Complete([&](detail::FutureState<T>& state) { state.exception = exception; });
+		}
+
+	private:
+		void CheckState() const
+		{
+			if (!m_state)
+				throw std::future_error(std::future_errc::no_state);
+			if (m_satisfied)
+				throw std::future_error(std::future_errc::promise_already_satisfied);
+		}
+
+		// 값을 넣지 않고 사라지면 broken_promise.
+		void Abandon()
+		{
+			if (m_state && !m_satisfied) {
+				set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+			}
+		}
+
+		std::shared_ptr<detail::FutureState<T>> m_state;
+		bool m_futureRetrieved{ false };
+		bool m_satisfied{ false };
+	};
+
+	template <class T>
+	Future<std::decay_t<T>> make_ready_future(T&& value)
+	{
+		Promise<std::decay_t<T>> promise;
+		auto future = promise.get_future();
+		promise.set_value(std::forward<T>(value));
+		return future;
+	}
+
+	inline Future<void> make_ready_future()
+	{
+		Promise<void> promise;
+		auto future = promise.get_future();
+		promise.set_value();
+		return future;
+	}
+
+	template <class T>
+	template <class Executor, class F>
+	auto Future<T>::then(Executor& executor, F&& f) &&
+	{
+		using R = typename std::conditional_t<std::is_void_v<T>,
+			std::invoke_result<std::decay_t<F>&>,
+			std::invoke_result<std::decay_t<F>&, T>>::type;
+
+		Promise<R> promise;
+		Future<R> next = promise.get_future();
+
+		// 완료되면 executor 에 작업을 넣는다.
+		// 넣지 못하면(종료된 pool 등) 그 예외를 다음 future 에 넣는다. (완료시킨 쪽의 set_value 로 던지지 않음)
+		auto state = m_state;
+		m_state->OnReady([state = std::move(state), &executor, promise = std::move(promise),
+			f = std::forward<F>(f)]() mutable {
+			detail::ThenTask<T, R, std::decay_t<F>> task{ std::move(state), std::move(promise), std::move(f) };
+			try {
+				executor.Post(std::move(task));
+			}
+			catch (...) {
+				// task 가 옮겨진 뒤에 실패했으면 promise 는 버려지면서 broken_promise 를 남긴다.
+				if (task.state)
+					task.promise.set_exception(std::current_exception());
+			}
+		});
+		m_state.reset();
+		return next;
+	}
+
+	// 모든 future 가 끝나면 완료되는 future. (Concurrency TS 와 같이 완료된 future 들을 돌려줌)
+	// - 등록 도중에 마지막 future 가 완료되어 futures 를 옮겨 가지 않도록,
+	//   등록하는 쪽도 카운터를 하나 들고 있다가 마지막에 내려놓는다.
+	template <class T>
+	Future<std::vector<Future<T>>> when_all(std::vector<Future<T>> futures)
+	{
+		struct Context
+		{
+			std::vector<Future<T>> futures;
+			std::atomic<size_t> remaining;
+			Promise<std::vector<Future<T>>> promise;
+		};
+
+		if (futures.empty()) {
+			return make_ready_future(std::move(futures));
+		}
+
+		auto ctx = std::allocate_shared<Context>(PoolAllocator<Context>());
+		auto result = ctx->promise.get_future();
+		ctx->remaining = futures.size() + 1;
+		ctx->futures = std::move(futures);
+
+		auto arrive = [ctx]() {
+			if (ctx->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				ctx->promise.set_value(std::move(ctx->futures));
+		};
+		for (auto& future : ctx->futures) {
+			future.OnReady(arrive);
+		}
+		arrive();
+		return result;
+	}
+
+	template <class... T>
+	Future<std::tuple<Future<T>...>> when_all(Future<T>&&... futures)
+	{
+		struct Context
+		{
+			std::tuple<Future<T>...> futures;
+			std::atomic<size_t> remaining{ sizeof...(T) + 1 };
+			Promise<std::tuple<Future<T>...>> promise;
+		};
+
+		auto ctx = std::allocate_shared<Context>(PoolAllocator<Context>());
+		auto result = ctx->promise.get_future();
+		ctx->futures = std::make_tuple(std::move(futures)...);
+
+		auto arrive = [ctx]() {
+			if (ctx->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				ctx->promise.set_value(std::move(ctx->futures));
+		};
+		std::apply([&arrive](auto&... future) { (future.OnReady(arrive), ...); }, ctx->futures);
+		arrive();
+		return result;
+	}
+
+	template <class Sequence>
+	struct WhenAnyResult
+	{
+		size_t index;
+		Sequence futures;
+	};
+
+	// 가장 먼저 끝난 future 의 index 와 전체 future 들을 돌려준다.
+	// 나머지 future 에 걸어 둔 continuation 은 제거하므로, 돌려받은 future 에 다시 then() 가능.
+	template <class T>
+	Future<WhenAnyResult<std::vector<Future<T>>>> when_any(std::vector<Future<T>> futures)
+	{
+		using Result = WhenAnyResult<std::vector<Future<T>>>;
+		struct Context
+		{
+			std::vector<Future<T>> futures;
+			std::atomic<bool> fired{ false };
+			std::atomic<size_t> index{ 0 };
+			std::atomic<int> remaining{ 2 }; // 처음 완료된 future + 등록 완료
+			Promise<Result> promise;
+		};
+
+		if (futures.empty()) {
+			return make_ready_future(Result{ static_cast<size_t>(-1), std::move(futures) });
+		}
+
+		auto ctx = std::allocate_shared<Context>(PoolAllocator<Context>());
+		auto result = ctx->promise.get_future();
+		ctx->futures = std::move(futures);
+
+		// 처음 완료된 쪽과 등록 loop 중 나중에 끝나는 쪽이 결과를 넘긴다.
+		// (등록 도중에 완료되어도 loop 가 도는 ctx->futures 를 옮기지 않도록)
+		auto publish = [ctx]() {
+			if (ctx->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+			const size_t index = ctx->index.load(std::memory_order_relaxed);
+			for (size_t j = 0; j < ctx->futures.size(); ++j) {
+				if (j != index)
+					ctx->futures[j].ClearContinuation();
+			}
+			ctx->promise.set_value(Result{ index, std::move(ctx->futures) });
+		};
+		for (size_t i = 0; i < ctx->futures.size(); ++i) {
+			ctx->futures[i].OnReady([ctx, i, publish]() {
+				if (ctx->fired.exchange(true, std::memory_order_acq_rel))
+					return;
+				ctx->index.store(i, std::memory_order_relaxed);
+				publish();
+			});
+		}
+		publish();
+		return result;
+	}
+
+}  // namespace ThreadPool
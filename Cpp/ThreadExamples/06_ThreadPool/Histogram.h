@@ -0,0 +1,164 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+
+namespace ThreadPool
+{
+	// 지연 시간(ns) 분포용 bucket 규칙.
+	// - 8 미만은 값 그대로, 그 이상은 2의 거듭제곱 구간을 8 칸으로 나눈다. (오차 12.5% 이내)
+	// - 2^40 ns(약 18분) 이상은 마지막 bucket 에 모은다.
+	struct HistogramBuckets
+	{
+		static constexpr int kSubBits = 3;
+		static constexpr uint64_t kSubCount = 1 << kSubBits;
+		static constexpr int kMaxExponent = 40;
+		static constexpr size_t kNumBuckets = kSubCount + (kMaxExponent - kSubBits) * kSubCount;
+
+		static size_t Index(uint64_t value)
+		{
+			if (value < kSubCount)
+				return static_cast<size_t>(value);
+			const int width = std::bit_width(value);
+			if (width > kMaxExponent)
+				return kNumBuckets - 1;
+			const int exponent = width - 1;
+			const uint64_t sub = (value >> (exponent - kSubBits)) & (kSubCount - 1);
+			return static_cast<size_t>(kSubCount + (exponent - kSubBits) * kSubCount + sub);
+		}
+
+		// bucket 에 들어가는 가장 큰 값
+		static uint64_t UpperBound(size_t index)
+		{
+			if (index < kSubCount)
+				return index;
+			const int exponent = static_cast<int>((index - kSubCount) / kSubCount) + kSubBits;
+			const uint64_t sub = (index - kSubCount) % kSubCount;
+			const uint64_t width = uint64_t(1) << (exponent - kSubBits);
+			return ((kSubCount + sub) << (exponent - kSubBits)) + width - 1;
+		}
+	};
+
+	// 동기화하지 않는 histogram.
+	// - 한 쓰레드(또는 lock 안) 에서 Record 로 기록하거나, AtomicHistogram::Snapshot() 의 복사본을 Merge 로 합친다.
+	class Histogram
+	{
+	public:
+		void Record(uint64_t value)
+		{
+			++m_buckets[HistogramBuckets::Index(value)];
+			++m_count;
+			m_sum += value;
+			m_max = std::max(m_max, value);
+		}
+
+		uint64_t Count() const { return m_count; }
+		uint64_t Max() const { return m_max; }
+		double Mean() const { return m_count ? static_cast<double>(m_sum) / m_count : 0.0; }
+
+		// p(0~1) 번째 값의 근사값. (해당 bucket 의 상한)
+		uint64_t Percentile(double p) const
+		{
+			if (m_count == 0)
+				return 0;
+			const uint64_t rank = static_cast<uint64_t>(p * (m_count - 1)) + 1;
+			uint64_t seen = 0;
+			for (size_t i = 0; i < HistogramBuckets::kNumBuckets; ++i) {
+				seen += m_buckets[i];
+				if (seen >= rank)
+					return std::min(HistogramBuckets::UpperBound(i), m_max);
+			}
+			return m_max;
+		}
+
+		void Merge(const Histogram& other)
+		{
+			for (size_t i = 0; i < HistogramBuckets::kNumBuckets; ++i) m_buckets[i] += other.m_buckets[i];
+			m_count += other.m_count;
+			m_sum += other.m_sum;
+			m_max = std::max(m_max, other.m_max);
+		}
+
+		// "count: .., mean: .., p50: .., p99: .., max: .." + 비어 있지 않은 구간 목록
+		// 목록은 읽기 쉽도록 2의 거듭제곱 구간으로 묶는다. ([2^(k-1), 2^k), 0 은 따로)
+		std::string ToString() const
+		{
+			std::string text = std::format("count: {}, mean: {:.1f}, p50: <={}, p99: <={}, max: {}",
+				m_count, Mean(), Percentile(0.50), Percentile(0.99), m_max);
+			uint64_t count = 0;
+			for (size_t i = 0; i < HistogramBuckets::kNumBuckets; ++i) {
+				count += m_buckets[i];
+				const uint64_t upper = HistogramBuckets::UpperBound(i);
+				const bool lastInGroup = i + 1 == HistogramBuckets::kNumBuckets
+					|| std::bit_width(HistogramBuckets::UpperBound(i + 1)) != std::bit_width(upper);
+				if (lastInGroup && count != 0) {
+					text += std::format("\n    <= {:>12}: {}", upper, count);
+					count = 0;
+				}
+			}
+			return text;
+		}
+
+	private:
+		friend class AtomicHistogram;
+
+		std::array<uint64_t, HistogramBuckets::kNumBuckets> m_buckets{};
+		uint64_t m_count{ 0 };
+		uint64_t m_sum{ 0 };
+		uint64_t m_max{ 0 };
+	};
+
+	// 쓰는 쓰레드 하나(보통 worker 자신), 읽는 쓰레드 여럿인 histogram.
+	// - 쓰는 쪽은 relaxed load + store 만 사용 (lock 접두어 명령 없음)
+	// - 읽는 쪽은 언제든 Snapshot() 으로 복사해 간다. (bucket 사이의 순간적인 불일치는 허용)
+	class AtomicHistogram
+	{
+	public:
+		void Record(uint64_t value)
+		{
+			Increment(m_buckets[HistogramBuckets::Index(value)], 1);
+			Increment(m_count, 1);
+			Increment(m_sum, value);
+			if (value > m_max.load(std::memory_order_relaxed))
+				m_max.store(value, std::memory_order_relaxed);
+		}
+
+		Histogram Snapshot() const
+		{
+			Histogram snapshot;
+			for (size_t i = 0; i < HistogramBuckets::kNumBuckets; ++i)
+				snapshot.m_buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+			snapshot.m_count = m_count.load(std::memory_order_relaxed);
+			snapshot.m_sum = m_sum.load(std::memory_order_relaxed);
+			snapshot.m_max = m_max.load(std::memory_order_relaxed);
+			return snapshot;
+		}
+
+		// 쓰는 쓰레드가 없을 때만 정확하다.
+		void Reset()
+		{
+			for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+			m_count.store(0, std::memory_order_relaxed);
+			m_sum.store(0, std::memory_order_relaxed);
+			m_max.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		static void Increment(std::atomic<uint64_t>& counter, uint64_t value)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		std::array<std::atomic<uint64_t>, HistogramBuckets::kNumBuckets> m_buckets{};
+		std::atomic<uint64_t> m_count{ 0 };
+		std::atomic<uint64_t> m_sum{ 0 };
+		std::atomic<uint64_t> m_max{ 0 };
+	};
+
+}  // namespace ThreadPool
@@ -0,0 +1,294 @@
+﻿#pragma once
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "PoolAllocator.h"
+
+namespace ThreadPool
+{
+	// 작업이 실행되지 않고 버려진 이유.
+	enum class CancelReason : uint8_t
+	{
+		None,      // 버리지 않음 (실행)
+		Cancelled, // stop_token 으로 취소 요청됨
+		Timeout,   // 기한 안에 시작하지 못함
+		Shed,      // queue 가 가득 차서 밀려남
+		Shutdown,  // Shutdown(Discard)
+	};
+	inline constexpr size_t kNumCancelReasons = 5;
+
+	// 실행 전에 스스로 취소 여부를 판단하는 callable.
+	// - CheckCancel(): 지금 버려야 하면 그 이유, 아니면 None.
+	template <class Func>
+	concept SelfCancellingCallable = requires(Func& f) {
+		{ f.CheckCancel() } -> std::same_as<CancelReason>;
+	};
+
+	// 버려질 때 알림을 받는 callable.
+	// - Cancel(reason): 실행하는 대신 호출된다. (결과를 기다리는 쪽에 알리기 등)
+	template <class Func>
+	concept CancelNotifiedCallable = requires(Func& f, CancelReason reason) {
+		f.Cancel(reason);
+	};
+
+	// std::function<void()> 대신 사용하는 move-only 작업 객체.
+	// - 작은 callable 은 내부 버퍼(kInlineSize) 에 직접 저장 (heap 할당 없음).
+	// - 버퍼보다 큰 callable 은 BlockPool 에서 블록을 받아 저장. (기본 정렬보다 큰 정렬이 필요하면 정렬 new)
+	class Job
+	{
+	public:
+		static constexpr size_t kInlineSize = 48; // sizeof(Job) == 64
+
+		Job() noexcept = default;
+
+		template <class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Job>>>
+		Job(F&& f)
+		{
+			using Func = std::decay_t<F>;
+			if constexpr (FitsInline<Func>) {
+				::new (static_cast<void*>(m_storage)) Func(std::forward<F>(f));
+				m_ops = &InlineOps<Func>::ops;
+			}
+			else {
+				void* block = AllocateHeap<Func>();
+				try {
+					::new (block) Func(std::forward<F>(f));
+				}
+				catch (...) {
+					FreeHeap<Func>(block);
+					throw;
+				}
+				*reinterpret_cast<void**>(m_storage) = block;
+				m_ops = &HeapOps<Func>::ops;
+			}
+		}
+
+		Job(Job&& other) noexcept { MoveFrom(other); }
+
+		Job& operator=(Job&& other) noexcept
+		{
+			if (this != &other) {
+				Reset();
+				MoveFrom(other);
+			}
+			return *this;
+		}
+
+		Job(const Job&) = delete;
+		Job& operator=(const Job&) = delete;
+
+		~Job() { Reset(); }
+
+		explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+		void operator()() { m_ops->invoke(m_storage); }
+
+		// 실행 전에 버려야 하는지. (SelfCancellingCallable 이 아니면 항상 None)
+		CancelReason CheckCancel() { return m_ops->checkCancel ? m_ops->checkCancel(m_storage) : CancelReason::None; }
+
+		// 버려도 되는 작업인지. (취소를 지원하지 않는 작업은 버려도 기다리는 쪽이 알 수 없으므로 항상 실행)
+		bool IsCancellable() const noexcept { return m_ops->checkCancel != nullptr || m_ops->cancel != nullptr; }
+
+		// 실행하지 않고 버린다.
+		void Cancel(CancelReason reason)
+		{
+			if (m_ops->cancel)
+				m_ops->cancel(m_storage, reason);
+			Reset();
+		}
+
+		// queue 에 들어간 시각. (대기 시간을 재지 않으면 기본값)
+		// Job 의 남는 padding 자리를 쓰므로 크기는 그대로 64 byte.
+		void SetEnqueueTime(std::chrono::steady_clock::time_point time) noexcept { m_enqueueTime = time; }
+		std::chrono::steady_clock::time_point GetEnqueueTime() const noexcept { return m_enqueueTime; }
+
+		void Reset() noexcept
+		{
+			if (m_ops) {
+				m_ops->destroy(m_storage);
+				m_ops = nullptr;
+			}
+		}
+
+	private:
+		struct Ops
+		{
+			void (*invoke)(void* storage);
+			void (*move)(void* dst, void* src) noexcept; // src 는 move 후 파괴까지 끝난 상태
+			void (*destroy)(void* storage) noexcept;
+			CancelReason (*checkCancel)(void* storage); // 취소를 지원하지 않으면 nullptr
+			void (*cancel)(void* storage, CancelReason reason);
+		};
+
+		template <class Func, class Access>
+		static constexpr auto CheckCancelOp()
+		{
+			if constexpr (SelfCancellingCallable<Func>)
+				return +[](void* storage) { return Access::Ref(storage).CheckCancel(); };
+			else
+				return static_cast<CancelReason(*)(void*)>(nullptr);
+		}
+
+		template <class Func, class Access>
+		static constexpr auto CancelOp()
+		{
+			if constexpr (CancelNotifiedCallable<Func>)
+				return +[](void* storage, CancelReason reason) { Access::Ref(storage).Cancel(reason); };
+			else
+				return static_cast<void(*)(void*, CancelReason)>(nullptr);
+		}
+
+		template <class Func>
+		static constexpr bool FitsInline =
+			sizeof(Func) <= kInlineSize &&
+			alignof(Func) <= alignof(std::max_align_t) &&
+			std::is_nothrow_move_constructible_v<Func>;
+
+		template <class Func>
+		struct InlineOps
+		{
+			static Func& Get(void* storage) { return *std::launder(reinterpret_cast<Func*>(storage)); }
+			static Func& Ref(void* storage) { return Get(storage); }
+
+			static constexpr Ops ops{
+				[](void* storage) { Get(storage)(); },
+				[](void* dst, void* src) noexcept {
+					::new (dst) Func(std::move(Get(src)));
+					Get(src).~Func();
+				},
+				[](void* storage) noexcept { Get(storage).~Func(); },
+				CheckCancelOp<Func, InlineOps>(),
+				CancelOp<Func, InlineOps>(),
+			};
+		};
+
+		// BlockPool 블록은 기본 new 정렬까지만 보장한다.
+		template <class Func>
+		static constexpr bool OverAligned = alignof(Func) > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+		template <class Func>
+		static void* AllocateHeap()
+		{
+			if constexpr (OverAligned<Func>)
+				return ::operator new(sizeof(Func), std::align_val_t(alignof(Func)));
+			else
+				return BlockPool::Allocate(sizeof(Func));
+		}
+
+		template <class Func>
+		static void FreeHeap(void* block) noexcept
+		{
+			if constexpr (OverAligned<Func>)
+				::operator delete(block, sizeof(Func), std::align_val_t(alignof(Func)));
+			else
+				BlockPool::Deallocate(block, sizeof(Func));
+		}
+
+		template <class Func>
+		struct HeapOps
+		{
+			static Func*& Get(void* storage) { return *reinterpret_cast<Func**>(storage); }
+			static Func& Ref(void* storage) { return *Get(storage); }
+
+			static constexpr Ops ops{
+				[](void* storage) { (*Get(storage))(); },
+				[](void* dst, void* src) noexcept { Get(dst) = Get(src); },
+				[](void* storage) noexcept {
+					Func* func = Get(storage);
+					func->~Func();
+					FreeHeap<Func>(func);
+				},
+				CheckCancelOp<Func, HeapOps>(),
+				CancelOp<Func, HeapOps>(),
+			};
+		};
+
+		void MoveFrom(Job& other) noexcept
+		{
+			if (other.m_ops) {
+				other.m_ops->move(m_storage, other.m_storage);
+				m_ops = std::exchange(other.m_ops, nullptr);
+			}
+			m_enqueueTime = other.m_enqueueTime;
+		}
+
+		alignas(std::max_align_t) unsigned char m_storage[kInlineSize];
+		const Ops* m_ops{ nullptr };
+		std::chrono::steady_clock::time_point m_enqueueTime{};
+	};
+	static_assert(sizeof(Job) == 64);
+
+	// Job 용 ring buffer.
+	// - 앞/뒤 모두 pop 가능해서 global queue(FIFO) 와 worker deque(LIFO + steal) 에 같이 사용.
+	// - std::deque 처럼 push/pop 마다 블록을 할당/해제하지 않고, 가득 찼을 때만 2배로 늘린다.
+	class JobQueue
+	{
+	public:
+		bool Empty() const { return m_head == m_tail; }
+		size_t Size() const { return m_tail - m_head; }
+
+		void Push(Job&& job)
+		{
+			if (Size() == m_capacity)
+				Grow();
+			m_buffer[m_tail & (m_capacity - 1)] = std::move(job);
+			++m_tail;
+		}
+
+		Job PopFront()
+		{
+			Job job = std::move(m_buffer[m_head & (m_capacity - 1)]);
+			++m_head;
+			return job;
+		}
+
+		Job PopBack()
+		{
+			--m_tail;
+			return std::move(m_buffer[m_tail & (m_capacity - 1)]);
+		}
+
+		// 앞에서부터 pred 를 만족하는 첫 작업을 꺼낸다. (앞쪽 작업들은 한 칸씩 뒤로 밀어 순서 유지)
+		template <class Pred>
+		bool PopFirstIf(Pred pred, Job& out)
+		{
+			for (size_t i = m_head; i != m_tail; ++i) {
+				if (!pred(m_buffer[i & (m_capacity - 1)]))
+					continue;
+				out = std::move(m_buffer[i & (m_capacity - 1)]);
+				for (; i != m_head; --i)
+					m_buffer[i & (m_capacity - 1)] = std::move(m_buffer[(i - 1) & (m_capacity - 1)]);
+				++m_head;
+				return true;
+			}
+			return false;
+		}
+
+	private:
+		void Grow()
+		{
+			const size_t newCapacity = m_capacity ? m_capacity * 2 : 64;
+			auto newBuffer = std::make_unique<Job[]>(newCapacity);
+			for (size_t i = 0; i < Size(); ++i) {
+				newBuffer[i] = std::move(m_buffer[(m_head + i) & (m_capacity - 1)]);
+			}
+			m_tail = Size();
+			m_head = 0;
+			m_buffer = std::move(newBuffer);
+			m_capacity = newCapacity;
+		}
+
+		std::unique_ptr<Job[]> m_buffer;
+		size_t m_capacity{ 0 }; // 항상 2의 거듭제곱
+		size_t m_head{ 0 };
+		size_t m_tail{ 0 };
+	};
+
+}  // namespace ThreadPool
@@ -0,0 +1,144 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "WaitGroup.h"
+
+namespace ThreadPool
+{
+	// [begin, end) 인덱스 범위
+	struct Range
+	{
+		size_t begin{ 0 };
+		size_t end{ 0 };
+
+		size_t Size() const { return end - begin; }
+	};
+
+	namespace detail
+	{
+		// parallel_for / parallel_reduce 한 번의 호출이 공유하는 상태.
+		// - 호출자 stack 에 두고, 분할된 작업들은 포인터만 들고 간다. (Job 내부 버퍼에 들어감)
+		template <class Leaf>
+		struct SplitContext
+		{
+			SplitContext(ThreadPool& executor, size_t grainSize, Leaf& leafFn) : pool(executor), grain(grainSize), leaf(leafFn) {}
+
+			ThreadPool& pool;
+			size_t grain;
+			Leaf& leaf;
+			WaitGroup waitGroup{ 1 };
+
+			std::mutex exceptionMutex;
+			std::exception_ptr exception;
+		};
+
+		// 범위를 grain 이하가 될 때까지 반으로 나누면서 오른쪽 절반을 pool 에 넘기고,
+		// 남은 왼쪽 조각은 현재 쓰레드가 직접 처리한다.
+		template <class Leaf>
+		void SplitAndRun(SplitContext<Leaf>* ctx, Range range)
+		{
+			try {
+				while (range.Size() > ctx->grain) {
+					const size_t mid = range.begin + range.Size() / 2;
+					ctx->waitGroup.Add();
+					try {
+						ctx->pool.Post([ctx, right = Range{ mid, range.end }]() { SplitAndRun(ctx, right); });
+					}
+					catch (...) {
+						// 넣지 못한 오른쪽 절반 몫. (예외는 아래에서 기록)
+						ctx->waitGroup.Done();
+						throw;
+					}
+					range.end = mid;
+				}
+				ctx->leaf(range);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(ctx->exceptionMutex);
+				if (!ctx->exception)
+					ctx->exception = std::current_exception();
+			}
+			ctx->waitGroup.Done();
+		}
+
+		template <class Leaf>
+		void RunSplit(ThreadPool& pool, Range range, size_t grain, Leaf& leaf)
+		{
+			if (range.Size() == 0)
+				return;
+
+			SplitContext<Leaf> ctx(pool, grain ? grain : 1, leaf);
+			SplitAndRun(&ctx, range);
+
+			// 호출자는 끝에서 한 번만 기다린다.
+			// worker 에서 호출됐으면(중첩) 기다리는 동안 다른 작업을 실행해서 pool 이 멈추지 않게 한다.
+			if (pool.GetCurrentWorkerIndex() != ThreadPool::kNotWorker)
+				pool.HelpUntil([&ctx]() { return ctx.waitGroup.IsDone(); });
+			ctx.waitGroup.Wait();
+			if (ctx.exception)
+				std::rethrow_exception(ctx.exception);
+		}
+
+		// worker 별 부분 결과.
+		// 07_FalseSharing 과 같이 cache-line 단위로 떨어뜨려 서로 다른 worker 의 갱신이 충돌하지 않게 한다.
+		template <class T>
+		struct alignas(std::hardware_destructive_interference_size) PaddedSlot
+		{
+			T value;
+		};
+	}
+
+	// body(Range) 또는 body(size_t index) 를 범위 전체에 대해 병렬로 호출한다.
+	template <class Body>
+	void parallel_for(ThreadPool& pool, Range range, size_t grain, Body&& body)
+	{
+		auto leaf = [&body](Range sub) {
+			if constexpr (std::is_invocable_v<Body&, Range>) {
+				body(sub);
+			}
+			else {
+				for (size_t i = sub.begin; i < sub.end; ++i)
+					body(i);
+			}
+		};
+		detail::RunSplit(pool, range, grain, leaf);
+	}
+
+	// 범위를 나눠 body(Range, T acc) -> T 로 누적하고, combine(T, T) -> T 로 합친다.
+	// - 조각마다 identity 에서 시작해 누적한 뒤 worker 별 slot 에 combine 하므로 한 slot 에 서로 떨어진 조각이 섞인다.
+	//   따라서 combine 은 결합/교환 법칙을 만족해야 하고, identity 는 항등원이어야 한다.
+	template <class T, class Body, class Combine>
+	T parallel_reduce(ThreadPool& pool, Range range, size_t grain, T identity, Body&& body, Combine&& combine)
+	{
+		// worker 마다 하나 + pool 밖의 호출자용 하나.
+		const size_t numSlots = pool.GetNumThreads() + 1;
+		std::vector<detail::PaddedSlot<T>> slots(numSlots, detail::PaddedSlot<T>{ identity });
+
+		auto leaf = [&](Range sub) {
+			size_t index = pool.GetCurrentWorkerIndex();
+			if (index == ThreadPool::kNotWorker)
+				index = numSlots - 1;
+			// body 안의 중첩 호출이 기다리는 동안 같은 worker 에서 다른 조각을 실행해 slot 을 갱신할 수 있으므로,
+			// slot 은 body 가 끝난 뒤에만 건드린다.
+			T part = body(sub, identity);
+			T& acc = slots[index].value;
+			acc = combine(std::move(acc), std::move(part));
+		};
+		detail::RunSplit(pool, range, grain, leaf);
+
+		T result = std::move(identity);
+		for (auto& slot : slots)
+			result = combine(std::move(result), std::move(slot.value));
+		return result;
+	}
+
+}  // namespace ThreadPool
@@ -0,0 +1,123 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+#include "FutexLock.h"
+
+namespace ThreadPool
+{
+	// 크기별(size class) free-list 로 블록을 재사용하는 전역 pool.
+	// - 한번 할당된 블록은 heap 에 돌려주지 않고 free-list 에 보관했다가 재사용.
+	// - 정상 상태(steady state) 에서는 heap 할당이 일어나지 않는다.
+	// - 할당/해제 쓰레드가 달라도 되도록 size class 별 mutex 로 보호. (임계 구역이 짧아 spin-then-futex 인 FutexMutex)
+	class BlockPool
+	{
+	public:
+		static constexpr size_t kMinBlockSize = 32;
+		static constexpr size_t kNumClasses = 8;  // 32, 64, ..., 4096 byte
+		static constexpr size_t kMaxBlockSize = kMinBlockSize << (kNumClasses - 1);
+
+		static void* Allocate(size_t size)
+		{
+			if (size > kMaxBlockSize)
+				return ::operator new(size);
+
+			SizeClass& sizeClass = GetClass(ClassIndex(size));
+			{
+				std::lock_guard<FutexMutex> lock(sizeClass.mutex);
+				if (FreeBlock* block = sizeClass.head) {
+					sizeClass.head = block->next;
+					return block;
+				}
+			}
+			return ::operator new(kMinBlockSize << ClassIndex(size));
+		}
+
+		static void Deallocate(void* ptr, size_t size) noexcept
+		{
+			if (size > kMaxBlockSize) {
+				::operator delete(ptr);
+				return;
+			}
+
+			SizeClass& sizeClass = GetClass(ClassIndex(size));
+			FreeBlock* block = static_cast<FreeBlock*>(ptr);
+			std::lock_guard<FutexMutex> lock(sizeClass.mutex);
+			block->next = sizeClass.head;
+			sizeClass.head = block;
+		}
+
+	private:
+		struct FreeBlock { FreeBlock* next; };
+
+		struct alignas(std::hardware_destructive_interference_size) SizeClass
+		{
+			explicit SizeClass(const char* name) : mutex(name) {}
+
+			FutexMutex mutex;
+			FreeBlock* head{ nullptr };
+		};
+
+		static size_t ClassIndex(size_t size)
+		{
+			size_t index = 0;
+			while ((kMinBlockSize << index) < size)
+				++index;
+			return index;
+		}
+
+		// size class 표는 파괴하지 않는다.
+		// DefaultPool() 같은 static 객체가 표보다 먼저 만들어지면 표가 먼저 파괴되는데,
+		// 그 객체의 소멸자(남은 작업, future 의 shared state 해제) 가 여전히 BlockPool 을 쓰기 때문.
+		// (블록은 어차피 heap 에 돌려주지 않으므로 파괴해도 할 일이 없다)
+		struct ImmortalClasses
+		{
+			union { SizeClass classes[kNumClasses]; };
+
+			ImmortalClasses()
+				: classes{
+					SizeClass("BlockPool(32)"), SizeClass("BlockPool(64)"), SizeClass("BlockPool(128)"), SizeClass("BlockPool(256)"),
+					SizeClass("BlockPool(512)"), SizeClass("BlockPool(1024)"), SizeClass("BlockPool(2048)"), SizeClass("BlockPool(4096)"),
+				}
+			{
+			}
+			~ImmortalClasses() {}
+		};
+
+		static SizeClass& GetClass(size_t index)
+		{
+			static ImmortalClasses table;
+			return table.classes[index];
+		}
+	};
+
+	// BlockPool 을 사용하는 표준 allocator.
+	// std::promise(std::allocator_arg, PoolAllocator<T>()) 처럼 future 의 shared state 에 사용.
+	template <typename T>
+	struct PoolAllocator
+	{
+		using value_type = T;
+
+		PoolAllocator() noexcept = default;
+
+		template <typename U>
+		PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+		T* allocate(std::size_t n)
+		{
+			static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned type");
+			return static_cast<T*>(BlockPool::Allocate(sizeof(T) * n));
+		}
+
+		void deallocate(T* ptr, std::size_t n) noexcept
+		{
+			BlockPool::Deallocate(ptr, sizeof(T) * n);
+		}
+
+		template <typename U>
+		bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+	};
+
+}  // namespace ThreadPool
@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace ThreadPool
+{
+	// spin 하는 동안 CPU 에 "기다리는 중" 이라고 알린다.
+	// - x86 pause: 같은 core 의 SMT 형제에게 자원을 양보하고, spin 을 빠져나올 때의 pipeline flush 를 줄인다.
+	// - ARM yield: 같은 의미의 hint.
+	inline void CpuRelax()
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+		__yield();
+#elif defined(__aarch64__) || defined(__arm__)
+		asm volatile("yield");
+#endif
+	}
+
+}  // namespace ThreadPool
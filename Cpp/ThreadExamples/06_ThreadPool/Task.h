@@ -0,0 +1,217 @@
+﻿#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "PoolAllocator.h"
+#include "ThreadPool.h"
+#include "WaitGroup.h"
+
+namespace ThreadPool
+{
+	template <class T = void> class Task;
+
+	namespace detail
+	{
+		struct TaskPromiseBase
+		{
+			// coroutine frame 은 BlockPool 에서 받아 재사용한다. (frame 크기별 free-list)
+			static void* operator new(std::size_t size) { return BlockPool::Allocate(size); }
+			static void operator delete(void* ptr, std::size_t size) noexcept { BlockPool::Deallocate(ptr, size); }
+
+			// 완료되면 기다리던 coroutine 으로 바로 넘어간다. (symmetric transfer)
+			// resume() 을 중첩 호출하지 않으므로 co_await chain 이 깊어도 stack 이 쌓이지 않는다.
+			struct FinalAwaiter
+			{
+				bool await_ready() noexcept { return false; }
+
+				template <class Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+				{
+					if (auto continuation = handle.promise().continuation)
+						return continuation;
+					return std::noop_coroutine();
+				}
+
+				void await_resume() noexcept {}
+			};
+
+			std::suspend_always initial_suspend() noexcept { return {}; } // lazy: co_await 할 때 시작
+			FinalAwaiter final_suspend() noexcept { return {}; }
+
+			void unhandled_exception() { exception = std::current_exception(); }
+
+			std::coroutine_handle<> continuation;
+			std::exception_ptr exception;
+		};
+
+		template <class T>
+		struct TaskPromise : TaskPromiseBase
+		{
+			Task<T> get_return_object();
+
+			template <class U>
+			void return_value(U&& value) { result.emplace(std::forward<U>(value)); }
+
+			T GetResult()
+			{
+				if (exception)
+					std::rethrow_exception(exception);
+				return std::move(*result);
+			}
+
+			std::optional<T> result;
+		};
+
+		template <>
+		struct TaskPromise<void> : TaskPromiseBase
+		{
+			Task<void> get_return_object();
+
+			void return_void() {}
+
+			void GetResult()
+			{
+				if (exception)
+					std::rethrow_exception(exception);
+			}
+		};
+	}
+
+	// co_await 로 결과를 받는 lazy coroutine.
+	// - 다른 쓰레드로 옮기려면 co_await schedule_on(pool) 을 사용한다.
+	// - 최상위(main 등) 에서는 sync_wait(task) 로 기다린다.
+	template <class T>
+	class Task
+	{
+	public:
+		using promise_type = detail::TaskPromise<T>;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other) {
+				if (m_handle) m_handle.destroy();
+				m_handle = std::exchange(other.m_handle, {});
+			}
+			return *this;
+		}
+		~Task() { if (m_handle) m_handle.destroy(); }
+
+		auto operator co_await() && noexcept
+		{
+			struct Awaiter
+			{
+				Handle handle;
+
+				bool await_ready() noexcept { return !handle || handle.done(); }
+
+				// 기다리는 쪽을 continuation 으로 등록하고 바로 task 를 시작.
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume() { return handle.promise().GetResult(); }
+			};
+			return Awaiter{ m_handle };
+		}
+
+	private:
+		friend struct detail::TaskPromise<T>;
+
+		explicit Task(Handle handle) : m_handle(handle) {}
+
+		Handle m_handle;
+	};
+
+	namespace detail
+	{
+		template <class T>
+		Task<T> TaskPromise<T>::get_return_object() { return Task<T>(Task<T>::Handle::from_promise(*this)); }
+
+		inline Task<void> TaskPromise<void>::get_return_object() { return Task<void>(Task<void>::Handle::from_promise(*this)); }
+
+		// sync_wait 에서 쓰는 즉시 시작/자동 파괴 coroutine.
+		struct DetachedTask
+		{
+			struct promise_type
+			{
+				static void* operator new(std::size_t size) { return BlockPool::Allocate(size); }
+				static void operator delete(void* ptr, std::size_t size) noexcept { BlockPool::Deallocate(ptr, size); }
+
+				DetachedTask get_return_object() noexcept { return {}; }
+				std::suspend_never initial_suspend() noexcept { return {}; }
+				std::suspend_never final_suspend() noexcept { return {}; }
+				void return_void() noexcept {}
+				void unhandled_exception() noexcept { std::terminate(); }
+			};
+		};
+
+		template <class T>
+		DetachedTask SyncWaitImpl(Task<T>& task, std::optional<T>& result, std::exception_ptr& exception, WaitGroup& done)
+		{
+			try {
+				result.emplace(co_await std::move(task));
+			}
+			catch (...) {
+				exception = std::current_exception();
+			}
+			done.Done();
+		}
+
+		inline DetachedTask SyncWaitImpl(Task<void>& task, std::exception_ptr& exception, WaitGroup& done)
+		{
+			try {
+				co_await std::move(task);
+			}
+			catch (...) {
+				exception = std::current_exception();
+			}
+			done.Done();
+		}
+	}
+
+	// 현재 coroutine 을 pool 의 worker 에서 이어서 실행한다.
+	// 새 쓰레드를 만들지 않고 pool 의 queue 를 통해 resume 된다.
+	inline auto schedule_on(ThreadPool& pool)
+	{
+		struct Awaiter
+		{
+			ThreadPool& pool;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) { pool.Post([handle]() { handle.resume(); }); }
+			void await_resume() const noexcept {}
+		};
+		return Awaiter{ pool };
+	}
+
+	// coroutine 이 아닌 곳에서 task 를 실행하고 끝날 때까지 기다린다.
+	template <class T>
+	T sync_wait(Task<T> task)
+	{
+		WaitGroup done(1);
+		std::exception_ptr exception;
+		if constexpr (std::is_void_v<T>) {
+			detail::SyncWaitImpl(task, exception, done);
+			done.Wait();
+			if (exception)
+				std::rethrow_exception(exception);
+		}
+		else {
+			std::optional<T> result;
+			detail::SyncWaitImpl(task, result, exception, done);
+			done.Wait();
+			if (exception)
+				std::rethrow_exception(exception);
+			return std::move(*result);
+		}
+	}
+
+}  // namespace ThreadPool
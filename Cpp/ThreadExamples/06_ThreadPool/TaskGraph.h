@@ -0,0 +1,175 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "WaitGroup.h"
+
+namespace ThreadPool
+{
+	// 의존 관계가 있는 작업들을 DAG 로 구성해서 pool 에서 실행한다.
+	// - 노드마다 선행 노드 수를 atomic 으로 세고, 0 이 되는 순간 그 노드를 pool 에 넣는다.
+	// - 작업 안에서 future.get() 으로 기다리지 않으므로 worker 가 막히지 않는다.
+	// - 한 번 만든 graph 는 Run() 을 반복 호출해서 매 frame 재사용할 수 있다.
+	class TaskGraph
+	{
+	public:
+		using NodeId = size_t;
+
+		NodeId AddNode(std::function<void()> work)
+		{
+			m_nodes.push_back({ std::move(work), {}, 0 });
+			m_prepared = false;
+			return m_nodes.size() - 1;
+		}
+
+		// to 는 from 이 끝난 뒤에 실행된다.
+		void AddEdge(NodeId from, NodeId to)
+		{
+			if (from >= m_nodes.size() || to >= m_nodes.size() || from == to) {
+				throw std::invalid_argument("TaskGraph: 잘못된 edge");
+			}
+			m_nodes[from].successors.push_back(to);
+			m_nodes[to].numPredecessors++;
+			m_prepared = false;
+		}
+
+		size_t GetNumNodes() const { return m_nodes.size(); }
+
+		// 모든 노드를 실행하고, 끝날 때까지 호출자만 대기한다. (worker 에서 호출하면 기다리는 동안 다른 작업을 실행)
+		// 노드에서 예외가 나면 이후 노드의 작업은 건너뛰고, 첫 번째 예외를 다시 던진다.
+		void Run(ThreadPool& pool)
+		{
+			if (m_nodes.empty())
+				return;
+			Prepare();
+
+			RunState state(this, pool);
+			state.waitGroup.Add(m_nodes.size());
+			for (NodeId id = 0; id < m_nodes.size(); ++id) {
+				m_pending[id].store(m_nodes[id].numPredecessors, std::memory_order_relaxed);
+			}
+			for (NodeId root : m_roots) {
+				pool.Post([s = &state, root]() { Execute(s, root); });
+			}
+
+			if (pool.GetCurrentWorkerIndex() != ThreadPool::kNotWorker)
+				pool.HelpUntil([&state]() { return state.waitGroup.IsDone(); });
+			state.waitGroup.Wait();
+			if (state.exception)
+				std::rethrow_exception(state.exception);
+		}
+
+	private:
+		struct Node
+		{
+			std::function<void()> work;
+			std::vector<NodeId> successors;
+			uint32_t numPredecessors;
+		};
+
+		struct RunState
+		{
+			RunState(TaskGraph* owner, ThreadPool& executor) : graph(owner), pool(executor) {}
+
+			TaskGraph* graph;
+			ThreadPool& pool;
+			WaitGroup waitGroup;
+
+			std::atomic<bool> failed{ false };
+			std::mutex exceptionMutex;
+			std::exception_ptr exception;
+		};
+
+		// graph 가 바뀐 뒤 처음 Run() 할 때만 root 목록/카운터 배열을 만들고 cycle 을 검사한다.
+		void Prepare()
+		{
+			if (m_prepared)
+				return;
+
+			m_roots.clear();
+			std::vector<uint32_t> pending(m_nodes.size());
+			for (NodeId id = 0; id < m_nodes.size(); ++id) {
+				pending[id] = m_nodes[id].numPredecessors;
+				if (pending[id] == 0)
+					m_roots.push_back(id);
+			}
+
+			// Kahn 알고리즘으로 모든 노드에 도달 가능한지 확인.
+			std::vector<NodeId> ready = m_roots;
+			size_t visited = 0;
+			while (!ready.empty()) {
+				NodeId id = ready.back();
+				ready.pop_back();
+				++visited;
+				for (NodeId succ : m_nodes[id].successors) {
+					if (--pending[succ] == 0)
+						ready.push_back(succ);
+				}
+			}
+			if (visited != m_nodes.size()) {
+				throw std::logic_error("TaskGraph: cycle 이 있음");
+			}
+
+			m_pending = std::make_unique<std::atomic<uint32_t>[]>(m_nodes.size());
+			m_prepared = true;
+		}
+
+		static void Execute(RunState* state, NodeId id)
+		{
+			TaskGraph* graph = state->graph;
+
+			// 준비된 후속 노드 하나는 pool 을 거치지 않고 이어서 실행한다. (chain 에서 queue 왕복 제거)
+			while (true) {
+				Node& node = graph->m_nodes[id];
+				if (!state->failed.load(std::memory_order_relaxed)) {
+					try {
+						if (node.work)
+							node.work();
+					}
+					catch (...) {
+						std::lock_guard<std::mutex> lock(state->exceptionMutex);
+						if (!state->exception)
+							state->exception = std::current_exception();
+						state->failed = true;
+					}
+				}
+
+				NodeId next = kNoNode;
+				for (NodeId succ : node.successors) {
+					if (graph->m_pending[succ].fetch_sub(1, std::memory_order_acq_rel) != 1)
+						continue;
+					if (next == kNoNode) {
+						next = succ;
+					}
+					else {
+						state->pool.Post([state, succ]() { Execute(state, succ); });
+					}
+				}
+
+				// next 가 남아 있으면 카운터가 0 이 될 수 없으므로 Done() 뒤에도 state 를 써도 된다.
+				// (next 가 없으면 Done() 이후 state 가 사라질 수 있으므로 바로 종료)
+				state->waitGroup.Done();
+				if (next == kNoNode)
+					return;
+				id = next;
+			}
+		}
+
+		static constexpr NodeId kNoNode = static_cast<NodeId>(-1);
+
+		std::vector<Node> m_nodes;
+		std::vector<NodeId> m_roots;
+		std::unique_ptr<std::atomic<uint32_t>[]> m_pending;
+		bool m_prepared{ false };
+	};
+
+}  // namespace ThreadPool
@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+#include "ThreadPool.h"
+
+namespace ThreadPool
+{
+	// 작업 묶음. Run 으로 넣고 Wait 로 모두 끝나기를 기다린다. (tbb::task_group 과 비슷)
+	// - worker 안에서 Wait 하면 기다리는 동안 queue 의 다른 작업(자기 자식 포함) 을 실행하므로,
+	//   작업 안에서 TaskGroup 을 만들어 재귀로 나눠도 깊이나 worker 수와 상관없이 멈추지 않는다.
+	// - 작업에서 나온 예외 중 첫 번째를 Wait 가 다시 던진다.
+	// - Wait 가 끝나면 다시 Run 할 수 있다. 소멸자는 남은 작업을 기다린다. (예외는 버림)
+	class TaskGroup
+	{
+	public:
+		explicit TaskGroup(ThreadPool& pool) : m_pool(pool) {}
+		~TaskGroup()
+		{
+			try {
+				Wait();
+			}
+			catch (...) {}
+		}
+
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		template <class F>
+		void Run(F&& f)
+		{
+			m_pending.fetch_add(1, std::memory_order_relaxed);
+			try {
+				m_pool.Post([this, f = std::forward<F>(f)]() mutable {
+					try {
+						f();
+					}
+					catch (...) {
+						SetException(std::current_exception());
+					}
+					Done();
+				});
+			}
+			catch (...) {
+				Done();
+				throw;
+			}
+		}
+
+		void Wait()
+		{
+			if (m_pool.GetCurrentWorkerIndex() != ThreadPool::kNotWorker)
+				m_pool.HelpUntil([this]() { return m_pending.load(std::memory_order_acquire) == 0; });
+
+			// worker 가 아니면 여기서 잠든다. worker 는 마지막 Done() 이 lock 을 놓을 때까지만 기다린다.
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [this]() { return m_pending.load(std::memory_order_acquire) == 0; });
+			if (m_exception) {
+				std::exception_ptr e = std::exchange(m_exception, nullptr);
+				lock.unlock();
+				std::rethrow_exception(e);
+			}
+		}
+
+	private:
+		// 마지막일 수 있는 감소만 lock 안에서 한다. (Wait 가 돌아온 뒤 바로 파괴해도 안전)
+		void Done()
+		{
+			size_t pending = m_pending.load(std::memory_order_relaxed);
+			while (pending > 1) {
+				if (m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+					return;
+			}
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				m_cv.notify_all();
+		}
+
+		void SetException(std::exception_ptr e)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_exception)
+				m_exception = std::move(e);
+		}
+
+		ThreadPool& m_pool;
+		std::atomic<size_t> m_pending{ 0 };
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::exception_ptr m_exception;
+	};
+
+}  // namespace ThreadPool
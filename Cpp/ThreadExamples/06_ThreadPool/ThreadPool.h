@@ -0,0 +1,1190 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "BulkHandle.h"
+#include "FutexLock.h"
+#include "Histogram.h"
+#include "Job.h"
+#include "PoolAllocator.h"
+#include "SpinWait.h"
+#include "TimerWheel.h"
+#include "Topology.h"
+
+//https://modoocode.com/285
+
+namespace ThreadPool
+{
+	// 작업 분배 방식
+	enum class SchedulingMode
+	{
+		GlobalQueue,  // 모든 worker 가 하나의 queue + mutex 를 공유.
+		WorkStealing, // worker 별 deque, 비어 있으면 다른 worker 의 작업을 훔쳐 옴.
+	};
+
+	// 작업 우선순위(lane). 높은 lane 부터 꺼낸다.
+	enum class Priority : uint8_t
+	{
+		High,   // 지연에 민감한 작업
+		Normal, // 기본값
+		Low,    // 배경 작업
+	};
+	inline constexpr size_t kNumPriorities = 3;
+
+	// 작업이 없을 때 worker 가 기다리는 방법: spin(pause) → yield → park(condition_variable)
+	// - park 된 worker 를 깨우려면 futex/커널 호출 + 스케줄링으로 수~수십 us 가 걸린다.
+	// - 짧은 작업이 띄엄띄엄 오면 잠깐 spin 하는 편이 빠르지만, 그동안 CPU 를 태운다.
+	struct IdlePolicy
+	{
+		std::chrono::nanoseconds spinTime{ 0 }; // pause 하며 queue 를 확인하는 최대 시간
+		uint32_t yieldCount{ 0 };               // 그 다음 yield 하며 확인하는 횟수
+		bool adaptive{ false };                 // spin 으로 작업을 받으면 spin 시간을 늘리고, 못 받고 park 하면 줄인다. (최대 spinTime)
+
+		static IdlePolicy Park() { return {}; } // 기본값 (바로 잠든다)
+		static IdlePolicy Spin(std::chrono::nanoseconds spinTime, uint32_t yieldCount = 0) { return { spinTime, yieldCount, false }; }
+		static IdlePolicy Adaptive(std::chrono::nanoseconds maxSpinTime, uint32_t yieldCount = 0) { return { maxSpinTime, yieldCount, true }; }
+	};
+
+	struct ThreadPoolOptions
+	{
+		SchedulingMode mode{ SchedulingMode::GlobalQueue };
+		// worker 를 CPU 에 고정하는 방법. (None 이 아니면 WorkStealing 에서 같은 L3 의 worker 부터 훔친다)
+		Placement placement{ Placement::None };
+		IdlePolicy idle{};
+		// worker 별 통계(실행 수, steal, busy/idle 시간) 기록. (Snapshot)
+		bool workerStats{ true };
+		// queue 에 쌓인 작업 수의 상한. (0: 제한 없음)
+		// 넘치면 새 작업과 같거나 낮은 lane 에서 가장 오래된 작업을 버린다(Shed). 그런 작업이 없으면 새 작업을 버린다.
+		// 취소를 지원하는 작업(EnqueueJob, Post(JobOptions) 등) 만 버린다. 일반 Post 는 버리면 기다리는 쪽
+		// (parallel_for, TaskGroup 등) 이 알 수 없으므로, 버릴 작업이 없으면 상한을 넘겨서라도 넣는다.
+		// 과부하에서 이미 늦어 버린 작업을 끝까지 처리하느라 새 작업까지 늦어지는 것을 막는다.
+		size_t maxQueuedJobs{ 0 };
+	};
+
+	// 작업별 제출 옵션.
+	struct JobOptions
+	{
+		Priority priority{ Priority::Normal };
+		// stop 이 요청되면 아직 시작하지 않은 작업은 실행하지 않고 버린다.
+		// 비어 있으면 pool 의 token(Shutdown(Discard) 에서 stop) 을 쓴다.
+		std::stop_token stopToken{};
+		// 0 이 아니면 제출 후 이 시간 안에 시작하지 못한 작업은 버린다.
+		std::chrono::nanoseconds timeout{ 0 };
+	};
+
+	// worker 하나의 통계.
+	struct WorkerStats
+	{
+		uint64_t jobsExecuted{ 0 };
+		uint64_t steals{ 0 };                   // 다른 worker 의 deque 에서 가져온 작업 수
+		uint64_t parks{ 0 };                    // 잠든(park) 횟수
+		std::chrono::nanoseconds busyTime{ 0 }; // 작업 실행 + 작업 찾기
+		std::chrono::nanoseconds idleTime{ 0 }; // 작업을 기다린 시간 (spin / yield / park)
+		size_t queueDepth{ 0 };                 // 자기 deque 에 쌓인 작업 수 (WorkStealing)
+		int cpu{ -1 };
+	};
+
+	// ThreadPool::Snapshot() 의 결과.
+	// worker 를 멈추지 않고 읽으므로 값들 사이에 약간의 시간차가 있을 수 있다.
+	struct ThreadPoolStats
+	{
+		std::vector<WorkerStats> workers;
+		size_t queuedJobs[kNumPriorities]{};         // lane 별 대기 중인 작업 수
+		Histogram queueWait[kNumPriorities]; // enqueue ~ 시작 (EnableQueueWaitMetrics(true) 일 때만)
+		uint64_t cancelled[kNumCancelReasons]{};     // 이유별 버려진 작업 수
+
+		uint64_t TotalJobsExecuted() const
+		{
+			uint64_t total = 0;
+			for (const auto& worker : workers) total += worker.jobsExecuted;
+			return total;
+		}
+
+		// 모든 worker 의 busy / (busy + idle)
+		double Utilization() const
+		{
+			std::chrono::nanoseconds busy{ 0 }, idle{ 0 };
+			for (const auto& worker : workers) {
+				busy += worker.busyTime;
+				idle += worker.idleTime;
+			}
+			const auto total = busy + idle;
+			return total.count() > 0 ? static_cast<double>(busy.count()) / total.count() : 0.0;
+		}
+	};
+
+	enum class ShutdownMode
+	{
+		Drain,   // queue 에 남은 작업을 모두 실행하고 종료
+		Discard, // 남은 작업은 버리고(일반 Post 는 실행), 실행 중인 작업에는 stop_token 으로 중단을 요청
+	};
+
+	// 작업이 실행되지 않고 버려졌을 때 future 로 전달되는 예외.
+	class JobCancelled : public std::runtime_error
+	{
+	public:
+		explicit JobCancelled(CancelReason reason)
+			: std::runtime_error(ToString(reason)), m_reason(reason) {}
+
+		CancelReason Reason() const { return m_reason; }
+
+		static const char* ToString(CancelReason reason)
+		{
+			switch (reason) {
+			case CancelReason::Cancelled: return "작업 취소됨";
+			case CancelReason::Timeout: return "작업 기한 초과";
+			case CancelReason::Shed: return "과부하로 작업 버려짐";
+			case CancelReason::Shutdown: return "ThreadPool 종료로 작업 버려짐";
+			default: return "작업 버려짐";
+			}
+		}
+
+	private:
+		CancelReason m_reason;
+	};
+
+	namespace detail
+	{
+		// JobOptions 로 제출된 작업의 취소 조건.
+		struct CancelCondition
+		{
+			std::stop_token token;
+			std::chrono::steady_clock::time_point deadline{}; // 기본값이면 기한 없음
+
+			CancelReason Check() const
+			{
+				if (token.stop_requested())
+					return CancelReason::Cancelled;
+				if (deadline != std::chrono::steady_clock::time_point{} && std::chrono::steady_clock::now() > deadline)
+					return CancelReason::Timeout;
+				return CancelReason::None;
+			}
+		};
+
+		// f(token, args...) 가 가능하면 token 을 첫 인자로 넘긴다. (std::jthread 와 같은 규칙)
+		template <class F, class... Args>
+		decltype(auto) InvokeWithToken(std::stop_token token, F& f, Args&... args)
+		{
+			if constexpr (std::is_invocable_v<F&, std::stop_token, Args&...>)
+				return std::invoke(f, std::move(token), args...);
+			else
+				return std::invoke(f, args...);
+		}
+
+		template <class F, class... Args>
+		using TokenInvokeResult = decltype(InvokeWithToken(std::declval<std::stop_token>(),
+			std::declval<std::decay_t<F>&>(), std::declval<std::decay_t<Args>&>()...));
+
+		// 결과를 promise 로 전달하는 작업. 버려지면 JobCancelled 를 전달한다.
+		template <class R, class Call>
+		struct PromiseTask
+		{
+			std::promise<R> promise;
+			Call call; // R()
+
+			void operator()()
+			{
+				try {
+					if constexpr (std::is_void_v<R>) {
+						call();
+						promise.set_value();
+					}
+					else {
+						promise.set_value(call());
+					}
+				}
+				catch (...) {
+					promise.set_exception(std::current_exception());
+				}
+			}
+			void Cancel(CancelReason reason) { promise.set_exception(std::make_exception_ptr(JobCancelled(reason))); }
+		};
+
+		// 취소 조건을 가진 PromiseTask.
+		template <class R, class Call>
+		struct CancellableTask : PromiseTask<R, Call>
+		{
+			CancelCondition condition;
+
+			CancelReason CheckCancel() const { return condition.Check(); }
+		};
+
+		// EnqueueBulk 의 작업 하나. 끝나거나 버려지면 묶음의 WaitGroup 을 줄인다.
+		// 실행도 Cancel 도 되지 않고 파괴되면(종료 중 push 와 엇갈린 경우 등) Shutdown 으로 취소된 것으로 센다.
+		// (그렇지 않으면 BulkHandle::Wait 가 영원히 기다림) state 가 nullptr 이면 이미 끝났거나 옮겨진 것.
+		template <class F>
+		struct BulkTask
+		{
+			BulkState* state;
+			F f;
+
+			BulkTask(BulkState* s, F fn) : state(s), f(std::move(fn)) {}
+			BulkTask(BulkTask&& other) noexcept(std::is_nothrow_move_constructible_v<F>)
+				: state(std::exchange(other.state, nullptr)), f(std::move(other.f)) {}
+			BulkTask& operator=(BulkTask&&) = delete;
+			~BulkTask()
+			{
+				if (state)
+					Cancel(CancelReason::Shutdown);
+			}
+
+			void operator()()
+			{
+				try {
+					f();
+				}
+				catch (...) {
+					state->SetException(std::current_exception());
+				}
+				std::exchange(state, nullptr)->waitGroup.Done();
+			}
+			void Cancel(CancelReason reason)
+			{
+				state->SetException(std::make_exception_ptr(JobCancelled(reason)));
+				std::exchange(state, nullptr)->waitGroup.Done();
+			}
+		};
+
+		// 결과가 없는 취소 가능 작업. (버려지면 그냥 파괴)
+		template <class Call>
+		struct CancellablePost
+		{
+			CancelCondition condition;
+			Call call; // void(std::stop_token)
+
+			void operator()() { call(condition.token); }
+			CancelReason CheckCancel() const { return condition.Check(); }
+		};
+	}
+
+	class ThreadPool
+	{
+	public:
+		ThreadPool(size_t numThread, SchedulingMode mode = SchedulingMode::GlobalQueue);
+		ThreadPool(size_t numThread, const ThreadPoolOptions& options);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// job 을 추가한다.
+		// - 작은 callable 은 Job 내부 버퍼에, future 의 shared state 는 BlockPool 에 저장되므로
+		//   정상 상태에서는 heap 할당 없이 제출된다.
+		template <class F, class... Args>
+			requires (!std::is_same_v<std::decay_t<F>, JobOptions>)
+		std::future<std::invoke_result_t<F, Args...>>
+			EnqueueJob(F&& f, Args&&... args);
+
+		// 우선순위를 지정해서 job 을 추가한다.
+		template <class F, class... Args>
+		std::future<std::invoke_result_t<F, Args...>>
+			EnqueueJob(Priority priority, F&& f, Args&&... args);
+
+		// 결과(future) 가 필요 없는 작업을 추가한다.
+		template <class F>
+		void Post(F&& f);
+
+		template <class F>
+		void Post(Priority priority, F&& f);
+
+		// 취소(stop_token) / 기한(timeout) 을 지정해서 job 을 추가한다.
+		// - 시작 전에 취소되거나 기한이 지나면 실행하지 않고, future 에 JobCancelled 를 전달한다.
+		//   (queue 에서 바로 빼지는 않고, worker 가 꺼낼 때 확인해서 버린다)
+		// - f 가 std::stop_token 을 첫 인자로 받을 수 있으면 넘겨준다. 실행 중에 확인해서 스스로 멈추면 된다.
+		template <class F, class... Args>
+		std::future<detail::TokenInvokeResult<F, Args...>>
+			EnqueueJob(const JobOptions& options, F&& f, Args&&... args);
+
+		template <class F>
+		void Post(const JobOptions& options, F&& f);
+
+		// [first, last) 의 callable(void()) 들을 한 번에 넣는다.
+		// - GlobalQueue 는 lock 한 번, WorkStealing 은 worker deque 마다 lock 한 번으로 넣고,
+		//   잠든 worker 는 작업 수만큼만 깨운다.
+		// - future N 개 대신 완료 handle 하나를 돌려준다. (실패한 작업의 예외는 BulkHandle::Get 으로)
+		// - move_iterator 를 넘기면 callable 을 복사하지 않고 옮긴다.
+		template <class It>
+		BulkHandle EnqueueBulk(It first, It last, Priority priority = Priority::Normal);
+
+		// delay 뒤에 f 를 pool 에 넣는다. (기다리는 동안 worker 를 쓰지 않음: 작업 안에서 sleep_for 하지 말 것)
+		// - 타이머는 첫 호출 때 만들어지는 TimerWheel(타이머 쓰레드 하나, 1ms 단위) 이 관리한다.
+		// - 만료되면 Post 와 같이 넣으므로, 실제 시작은 만료 + queue 대기 시간.
+		template <class F>
+		TimerId EnqueueAfter(std::chrono::nanoseconds delay, F&& f, Priority priority = Priority::Normal);
+
+		// period 마다 f 를 pool 에 넣는다. (첫 실행은 period 뒤)
+		// 이전 실행이 끝나지 않았어도 다음 실행을 넣는다. 밀려서 지나간 주기는 건너뛴다.
+		template <class F>
+		TimerId EnqueueEvery(std::chrono::nanoseconds period, F&& f, Priority priority = Priority::Normal);
+
+		// 아직 pool 에 넣지 않은 타이머를 취소한다. (반복 타이머는 이후 실행 모두)
+		bool CancelTimer(TimerId id)
+		{
+			TimerWheel* timers = Timers(false);
+			return timers ? timers->Cancel(id) : false;
+		}
+
+		// 작업 안에서 다른 작업의 결과를 기다릴 때 쓴다.
+		// worker 가 future.get() 으로 막히면 그 worker 는 아무 일도 못 하므로,
+		// worker 수만큼 그런 작업이 쌓이면 기다리는 결과를 실행할 worker 가 없어 pool 전체가 멈춘다.
+		// - HelpUntil(done): done() 이 true 가 될 때까지 queue 의 다른 작업을 대신 실행한다.
+		//   할 일이 없으면 spin → yield → 짧은 sleep 으로 물러난다. worker 가 아닌 쓰레드는 기다리기만 한다.
+		// - Await(future): worker 에서는 HelpUntil 로, 아니면 future.get() 으로 기다린다.
+		// 대신 실행한 작업이 길면 기다리던 결과를 늦게 보게 되고, 기다림이 중첩될 때마다 stack 이 깊어진다.
+		template <class Done>
+		void HelpUntil(Done&& done);
+
+		template <class T>
+		T Await(std::future<T>& future);
+
+		template <class T>
+		T Await(std::future<T>&& future) { return Await(future); }
+
+		// 현재 쓰레드가 worker 이면 queue 의 작업 하나를 꺼내 실행한다. 실행했으면 true.
+		bool TryRunPendingJob();
+
+		// 새 작업을 막고 worker 를 모두 종료한다. (소멸자는 Drain 으로 호출)
+		// 한 쓰레드에서만, worker 가 아닌 쓰레드에서 호출해야 한다.
+		void Shutdown(ShutdownMode mode = ShutdownMode::Drain);
+
+		// pool 의 stop_token. Shutdown(Discard) 에서 stop 이 요청된다.
+		std::stop_token GetStopToken() const { return m_stopSource.get_token(); }
+
+		// 실행되지 않고 버려진 작업 수.
+		uint64_t GetNumCancelled(CancelReason reason) const { return m_numCancelled[static_cast<size_t>(reason)].load(std::memory_order_relaxed); }
+
+		// lane 별 queue 대기 시간(enqueue ~ worker 가 꺼낸 시점, ns) 측정.
+		// 켜 두면 job 마다 시각을 두 번 읽는다. (기본은 꺼짐)
+		void EnableQueueWaitMetrics(bool enable) { m_queueWaitMetrics.store(enable, std::memory_order_relaxed); }
+		Histogram GetQueueWaitLatency(Priority priority) const;
+		void ResetQueueWaitLatency();
+
+		// 현재 통계. 실행 중에 언제든 호출할 수 있다. (worker 는 멈추지 않음)
+		ThreadPoolStats Snapshot() const;
+
+		size_t GetNumThreads() const { return m_numThread; }
+		SchedulingMode GetMode() const { return m_mode; }
+
+		// worker 가 고정된 CPU 번호. 고정하지 않았거나 실패했으면 -1.
+		int GetWorkerCpu(size_t index) const { return m_workerCpus[index].load(std::memory_order_relaxed); }
+
+		// worker 의 OS 쓰레드 id. (CurrentOsThreadId) worker 가 아직 시작하지 않았으면 0.
+		int GetWorkerThreadId(size_t index) const { return m_workerThreadIds[index].load(std::memory_order_acquire); }
+
+		// 현재 쓰레드가 이 pool 의 worker 이면 그 index, 아니면 kNotWorker.
+		static constexpr size_t kNotWorker = static_cast<size_t>(-1);
+		size_t GetCurrentWorkerIndex() const { return s_currentPool == this ? s_workerIndex : kNotWorker; }
+
+	private:
+		// worker 전용 작업 deque.
+		// - 소유 worker 는 뒤에서 push/pop (LIFO: 방금 만든 작업이 cache 에 남아 있음)
+		// - 다른 worker 는 앞에서 훔쳐 감 (FIFO: 오래된 작업을 가져가 충돌을 줄임)
+		// - 각 deque 의 mutex 는 거의 소유 worker 만 잡으므로 경합이 적다. (HottestLocks() 로 확인)
+		struct alignas(std::hardware_destructive_interference_size) WorkerQueue
+		{
+			FutexMutex mutex{ "WorkerQueue" };
+			JobQueue jobs[kNumPriorities];
+			std::atomic<size_t> depth{ 0 }; // lock 없이 읽는 용도 (mutex 안에서 갱신)
+
+			void UpdateDepth()
+			{
+				size_t total = 0;
+				for (const auto& lane : jobs) total += lane.Size();
+				depth.store(total, std::memory_order_relaxed);
+			}
+		};
+
+		// worker 가 직접 기록하는 통계. (worker 마다 따로 두어 cache-line 경합 없음)
+		// 쓰는 쓰레드가 하나뿐이므로 AtomicHistogram 처럼 relaxed load + store 로 증가시킨다.
+		// 시각은 대기에 들어가고 나올 때만 읽고, busy 시간은 (경과 - idle) 로 계산한다.
+		struct alignas(std::hardware_destructive_interference_size) WorkerMetrics
+		{
+			std::atomic<uint64_t> jobsExecuted{ 0 };
+			std::atomic<uint64_t> steals{ 0 };
+			std::atomic<uint64_t> parks{ 0 };
+			std::atomic<int64_t> startNs{ 0 };     // worker 시작 시각 (steady_clock, ns)
+			std::atomic<int64_t> idleNs{ 0 };      // 끝난 대기 시간의 합
+			std::atomic<int64_t> idleSinceNs{ 0 }; // 대기 중이면 그 시작 시각, 아니면 0
+			AtomicHistogram queueWait[kNumPriorities];
+
+			template <class T>
+			static void Add(std::atomic<T>& counter, T value)
+			{
+				counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+			}
+		};
+
+		static int64_t NowNs()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		// 낮은 lane 이 비어 있지 않은데 이 횟수보다 많이 밀리면 그 lane 을 먼저 꺼낸다.
+		// 따라서 밀려 있는 lane 도 최소 1 / (kStarvationLimit + 1) 의 몫은 처리된다.
+		static constexpr uint32_t kStarvationLimit = 16;
+		using SkipCounts = uint32_t[kNumPriorities];
+
+		void PlanWorkers(Placement placement);
+		void WorkerThread(size_t index); // Worker 쓰레드
+		void WorkerLoop(size_t index);
+		bool PopJob(size_t index, SkipCounts& skipped, size_t& lane, Job& job);
+		void WaitForJobs(size_t index, std::chrono::nanoseconds& spinBudget);
+		bool IdleForJobs(std::chrono::nanoseconds& spinBudget);
+		bool SpinForJobs(std::chrono::nanoseconds spinTime) const;
+
+		template <class HasJobs>
+		static size_t SelectLane(SkipCounts& skipped, HasJobs&& hasJobs);
+
+		// 타이머 wheel. create 이면 처음 부를 때 만든다. Shutdown 이후에는 만들지 않고 nullptr.
+		TimerWheel* Timers(bool create);
+		void PushJob(Job&& job, Priority priority);
+		void PushJobs(std::vector<Job>& jobs, Priority priority);
+		void WakeWorkers(size_t count);
+		bool PopLocalJob(size_t index, size_t lane, Job& job);
+		bool StealJob(size_t index, size_t lane, Job& job);
+		size_t NumQueuedJobs() const;
+		void RunJob(size_t index, size_t lane, Job& job);
+		void CancelJob(Job& job, CancelReason reason);
+		bool ShedOldest(JobQueue (&jobs)[kNumPriorities], size_t lane, Job& shed);
+
+	private:
+		SchedulingMode m_mode;
+		IdlePolicy m_idlePolicy;
+		bool m_workerStats;
+		size_t m_numThread; // worker 생성 중에도 안전하게 읽을 수 있도록 별도 보관.
+		std::vector<std::thread> m_workerThreads;
+
+		// worker 배치 (쓰레드 생성 전에 정해 둔다)
+		std::vector<int> m_plannedCpus;                    // -1: 고정하지 않음
+		std::unique_ptr<std::atomic<int>[]> m_workerCpus;  // 실제로 고정된 CPU
+		std::unique_ptr<std::atomic<int>[]> m_workerThreadIds;
+		std::vector<std::vector<size_t>> m_stealOrder;     // worker 별로 훔쳐 볼 worker 순서
+
+		// 작업 보관 (GlobalQueue)
+		JobQueue m_jobs[kNumPriorities];
+		SkipCounts m_skipped{}; // m_mutexForJobs 로 보호
+		std::condition_variable m_cvForJobs;
+		std::mutex m_mutexForJobs;
+
+		// 작업 보관 (WorkStealing)
+		std::unique_ptr<WorkerQueue[]> m_workerQueues;
+		std::atomic<size_t> m_nextQueue{ 0 }; // 외부 쓰레드의 push 분산용
+
+		// 대기 (두 방식 공통)
+		// - lane 별 개수는 spin 중 lock 없이 작업 도착을 확인하는 데 쓰고,
+		//   WorkStealing 에서는 어느 lane 을 볼지 정하는 힌트로도 쓴다.
+		// - park 는 m_mutexForJobs / m_cvForJobs 를 사용하고, 잠든 worker 가 없으면 notify 를 생략한다.
+		std::atomic<size_t> m_numQueuedJobs[kNumPriorities]{};
+		std::atomic<size_t> m_numSleeping{ 0 };
+
+		// 모든 쓰레드 종료
+		std::atomic<bool> m_stopAll{ false };
+		std::atomic<bool> m_discardQueued{ false }; // Shutdown(Discard): 남은 작업은 실행하지 않음
+		std::stop_source m_stopSource;
+
+		// 지연 / 반복 작업 (처음 쓸 때 생성)
+		// 만들기와 Shutdown 의 확인이 엇갈려 멈추지 않은 wheel 이 남지 않도록 m_timersMutex 안에서만 다룬다.
+		std::mutex m_timersMutex;
+		std::unique_ptr<TimerWheel> m_timers;
+		bool m_timersClosed{ false }; // Shutdown 이 시작되면 true
+
+		// 취소 / 과부하
+		size_t m_maxQueuedJobs;
+		std::atomic<uint64_t> m_numCancelled[kNumCancelReasons]{};
+
+		std::atomic<bool> m_queueWaitMetrics{ false };
+		std::unique_ptr<WorkerMetrics[]> m_workerMetrics;
+
+		// 현재 쓰레드가 어떤 pool 의 몇 번째 worker 인지.
+		static inline thread_local const ThreadPool* s_currentPool{ nullptr };
+		static inline thread_local size_t s_workerIndex{ 0 };
+	};
+
+	inline ThreadPool::ThreadPool(size_t numThread, SchedulingMode mode)
+		: ThreadPool(numThread, ThreadPoolOptions{ mode })
+	{
+	}
+
+	inline ThreadPool::ThreadPool(size_t numThread, const ThreadPoolOptions& options)
+		: m_mode(options.mode)
+		, m_idlePolicy(options.idle)
+		, m_workerStats(options.workerStats)
+		, m_numThread(numThread)
+		, m_maxQueuedJobs(options.maxQueuedJobs)
+	{
+		// worker 가 없으면 작업이 실행되지 않는다. (WorkStealing 은 worker 수로 deque 를 고름)
+		if (numThread == 0) {
+			throw std::invalid_argument("ThreadPool: numThread 는 0 보다 커야 함");
+		}
+		if (m_mode == SchedulingMode::WorkStealing) {
+			m_workerQueues = std::make_unique<WorkerQueue[]>(numThread);
+		}
+		m_workerMetrics = std::make_unique<WorkerMetrics[]>(numThread);
+		PlanWorkers(options.placement);
+
+		m_workerThreads.reserve(numThread);
+		for (size_t i = 0; i < numThread; ++i) {
+			m_workerThreads.emplace_back([this, i]() { this->WorkerThread(i); });
+		}
+	}
+
+	inline ThreadPool::~ThreadPool()
+	{
+		Shutdown(ShutdownMode::Drain);
+	}
+
+	inline void ThreadPool::Shutdown(ShutdownMode mode)
+	{
+		// 타이머 쓰레드가 먼저 멈춰야 종료 중인 pool 에 작업을 넣지 않는다. (남은 타이머는 버림)
+		TimerWheel* timers;
+		{
+			std::lock_guard<std::mutex> lock(m_timersMutex);
+			m_timersClosed = true;
+			timers = m_timers.get();
+		}
+		if (timers)
+			timers->Stop();
+		{
+			// 대기 조건 검사와 wait 사이에 끼어들지 않도록 lock 안에서 설정.
+			std::lock_guard<std::mutex> lock(m_mutexForJobs);
+			m_stopAll = true;
+			if (mode == ShutdownMode::Discard)
+				m_discardQueued = true;
+		}
+		if (mode == ShutdownMode::Discard)
+			m_stopSource.request_stop();
+		m_cvForJobs.notify_all();
+		for (auto& t : m_workerThreads) {
+			if (t.joinable())
+				t.join();
+		}
+	}
+
+	// worker 별 CPU 와 훔쳐 올 순서를 정한다.
+	// - 고정하지 않으면 index + 1 부터 차례로. (기존과 같음)
+	// - 고정하면 같은 L3 를 쓰는 worker 를 먼저 본다. (훔쳐 온 작업의 데이터가 L3 에 있을 가능성이 큼)
+	inline void ThreadPool::PlanWorkers(Placement placement)
+	{
+		std::vector<LogicalCpu> plan;
+		if (placement != Placement::None)
+			plan = CpuTopology::Detect().Plan(placement, m_numThread);
+
+		m_plannedCpus.assign(m_numThread, -1);
+		m_workerCpus = std::make_unique<std::atomic<int>[]>(m_numThread);
+		m_workerThreadIds = std::make_unique<std::atomic<int>[]>(m_numThread);
+		for (size_t i = 0; i < m_numThread; ++i) {
+			if (!plan.empty())
+				m_plannedCpus[i] = static_cast<int>(plan[i].id);
+			m_workerCpus[i].store(-1, std::memory_order_relaxed);
+			m_workerThreadIds[i].store(0, std::memory_order_relaxed);
+		}
+
+		m_stealOrder.assign(m_numThread, {});
+		for (size_t i = 0; i < m_numThread; ++i) {
+			std::vector<size_t>& order = m_stealOrder[i];
+			for (size_t k = 1; k < m_numThread; ++k)
+				order.push_back((i + k) % m_numThread);
+			if (!plan.empty()) {
+				std::stable_partition(order.begin(), order.end(),
+					[&](size_t victim) { return plan[victim].l3 == plan[i].l3; });
+			}
+		}
+	}
+
+	inline void ThreadPool::WorkerThread(size_t index)
+	{
+		s_currentPool = this;
+		s_workerIndex = index;
+
+		if (m_plannedCpus[index] >= 0 && PinCurrentThread(static_cast<uint32_t>(m_plannedCpus[index])))
+			m_workerCpus[index].store(m_plannedCpus[index], std::memory_order_relaxed);
+		m_workerThreadIds[index].store(CurrentOsThreadId(), std::memory_order_release);
+		if (m_workerStats)
+			m_workerMetrics[index].startNs.store(NowNs(), std::memory_order_relaxed);
+
+		WorkerLoop(index);
+	}
+
+	// 꺼낼 lane 을 고른다. 없으면 kNumPriorities.
+	// - 기본은 작업이 있는 가장 높은 lane.
+	// - 그보다 낮은 lane 은 밀릴 때마다 skipped 가 늘고, kStarvationLimit 를 넘으면 먼저 꺼낸다.
+	template <class HasJobs>
+	size_t ThreadPool::SelectLane(SkipCounts& skipped, HasJobs&& hasJobs)
+	{
+		size_t lane = 0;
+		while (lane < kNumPriorities && !hasJobs(lane)) ++lane;
+		if (lane == kNumPriorities)
+			return lane;
+		for (size_t lower = lane + 1; lower < kNumPriorities; ++lower) {
+			if (hasJobs(lower) && ++skipped[lower] > kStarvationLimit) {
+				lane = lower;
+				break;
+			}
+		}
+		skipped[lane] = 0;
+		return lane;
+	}
+
+	inline void ThreadPool::WorkerLoop(size_t index)
+	{
+		std::chrono::nanoseconds spinBudget = m_idlePolicy.spinTime;
+		SkipCounts skipped{};
+		while (true)
+		{
+			Job job;
+			size_t lane;
+			if (PopJob(index, skipped, lane, job)) {
+				RunJob(index, lane, job);
+				continue;
+			}
+
+			// 전체 중단 및 작업이 없는 경우 종료.
+			if (m_stopAll && NumQueuedJobs() == 0) {
+				return;
+			}
+			WaitForJobs(index, spinBudget);
+		}
+	}
+
+	// 다음에 실행할 작업을 꺼낸다. (skipped 는 WorkStealing 에서만 사용. GlobalQueue 는 m_skipped)
+	inline bool ThreadPool::PopJob(size_t index, SkipCounts& skipped, size_t& lane, Job& job)
+	{
+		if (m_mode == SchedulingMode::GlobalQueue) {
+			std::lock_guard<std::mutex> lock(m_mutexForJobs);
+			lane = SelectLane(m_skipped, [this](size_t l) { return !m_jobs[l].Empty(); });
+			if (lane == kNumPriorities)
+				return false;
+			job = m_jobs[lane].PopFront();
+			m_numQueuedJobs[lane].fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// lane 별 개수는 힌트이므로 고른 lane 에서 못 찾을 수 있다. (대기 조건에서 다시 확인)
+		lane = SelectLane(skipped, [this](size_t l) { return m_numQueuedJobs[l].load(std::memory_order_relaxed) > 0; });
+		return lane != kNumPriorities && (PopLocalJob(index, lane, job) || StealJob(index, lane, job));
+	}
+
+	inline bool ThreadPool::TryRunPendingJob()
+	{
+		const size_t index = GetCurrentWorkerIndex();
+		if (index == kNotWorker)
+			return false;
+		SkipCounts skipped{};
+		Job job;
+		size_t lane;
+		if (!PopJob(index, skipped, lane, job))
+			return false;
+		RunJob(index, lane, job);
+		return true;
+	}
+
+	// 작업이 들어오거나 종료될 때까지 기다린다. (대기 시간 기록)
+	inline void ThreadPool::WaitForJobs(size_t index, std::chrono::nanoseconds& spinBudget)
+	{
+		if (!m_workerStats) {
+			IdleForJobs(spinBudget);
+			return;
+		}
+		WorkerMetrics& metrics = m_workerMetrics[index];
+		const int64_t begin = NowNs();
+		metrics.idleSinceNs.store(begin, std::memory_order_relaxed);
+		if (IdleForJobs(spinBudget))
+			WorkerMetrics::Add(metrics.parks, uint64_t(1));
+		// Snapshot 이 같은 대기를 두 번 세지 않도록 idleSinceNs 를 먼저 지우고 idleNs 를 release 로 갱신.
+		metrics.idleSinceNs.store(0, std::memory_order_relaxed);
+		metrics.idleNs.store(metrics.idleNs.load(std::memory_order_relaxed) + (NowNs() - begin), std::memory_order_release);
+	}
+
+	// IdlePolicy 에 따라 기다린다. park 했으면 true.
+	inline bool ThreadPool::IdleForJobs(std::chrono::nanoseconds& spinBudget)
+	{
+		if (SpinForJobs(spinBudget)) {
+			if (m_idlePolicy.adaptive) // spin 이 효과가 있었으니 늘린다.
+				spinBudget = std::min(m_idlePolicy.spinTime, std::max(spinBudget * 2, std::chrono::nanoseconds(1000)));
+			return false;
+		}
+		if (m_idlePolicy.adaptive)
+			spinBudget /= 2;
+
+		// m_numSleeping 증가 후 m_numQueuedJobs 를 확인하고,
+		// PushJob 은 m_numQueuedJobs 증가 후 m_numSleeping 을 확인한다. (둘 다 seq_cst)
+		// 따라서 둘 중 한쪽은 반드시 상대를 보게 되어 wake-up 을 놓치지 않는다.
+		std::unique_lock<std::mutex> lock(m_mutexForJobs);
+		m_numSleeping.fetch_add(1);
+		m_cvForJobs.wait(lock, [this]() { return NumQueuedJobs() > 0 || m_stopAll; });
+		m_numSleeping.fetch_sub(1);
+		return true;
+	}
+
+	// spin → yield 하며 lock 없이 작업 도착을 확인한다. 도착했으면 true.
+	inline bool ThreadPool::SpinForJobs(std::chrono::nanoseconds spinTime) const
+	{
+		auto arrived = [this]() {
+			for (const auto& count : m_numQueuedJobs) {
+				if (count.load(std::memory_order_relaxed) > 0) return true;
+			}
+			return m_stopAll.load(std::memory_order_relaxed);
+		};
+
+		if (spinTime.count() > 0) {
+			const auto deadline = std::chrono::steady_clock::now() + spinTime;
+			while (true) {
+				// 시각은 가끔만 읽는다. (now() 자체가 수십 ns)
+				for (int i = 0; i < 64; ++i) {
+					if (arrived()) return true;
+					CpuRelax();
+				}
+				if (std::chrono::steady_clock::now() >= deadline)
+					break;
+			}
+		}
+		for (uint32_t i = 0; i < m_idlePolicy.yieldCount; ++i) {
+			if (arrived()) return true;
+			std::this_thread::yield();
+		}
+		return false;
+	}
+
+	inline size_t ThreadPool::NumQueuedJobs() const
+	{
+		size_t total = 0;
+		for (const auto& count : m_numQueuedJobs) total += count.load();
+		return total;
+	}
+
+	inline void ThreadPool::RunJob(size_t index, size_t lane, Job& job)
+	{
+		const auto enqueueTime = job.GetEnqueueTime();
+		if (enqueueTime != std::chrono::steady_clock::time_point{}) {
+			const auto wait = std::chrono::steady_clock::now() - enqueueTime;
+			m_workerMetrics[index].queueWait[lane].Record(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count());
+		}
+
+		const CancelReason reason = m_discardQueued.load(std::memory_order_relaxed) && job.IsCancellable()
+			? CancelReason::Shutdown : job.CheckCancel();
+		if (reason != CancelReason::None) {
+			CancelJob(job, reason);
+			return;
+		}
+		job();
+		if (m_workerStats)
+			WorkerMetrics::Add(m_workerMetrics[index].jobsExecuted, uint64_t(1));
+	}
+
+	inline void ThreadPool::CancelJob(Job& job, CancelReason reason)
+	{
+		m_numCancelled[static_cast<size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+		job.Cancel(reason);
+	}
+
+	// queue 가 가득 찼을 때 lane 과 같거나 낮은 lane 에서 가장 오래된 (취소 가능한) 작업을 꺼낸다. (lock 안에서 호출)
+	inline bool ThreadPool::ShedOldest(JobQueue (&jobs)[kNumPriorities], size_t lane, Job& shed)
+	{
+		for (size_t victim = kNumPriorities; victim-- > lane;) {
+			if (jobs[victim].PopFirstIf([](const Job& job) { return job.IsCancellable(); }, shed)) {
+				m_numQueuedJobs[victim].fetch_sub(1);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline void ThreadPool::PushJob(Job&& job, Priority priority)
+	{
+		const size_t lane = static_cast<size_t>(priority);
+		if (m_queueWaitMetrics.load(std::memory_order_relaxed))
+			job.SetEnqueueTime(std::chrono::steady_clock::now());
+
+		// 가득 찼는데 밀어낼 작업이 없으면 새 작업을 버린다. (버리는 작업의 Cancel 은 lock 밖에서)
+		// 새 작업도 취소를 지원하지 않으면 상한을 넘겨서 넣는다.
+		Job shed;
+		auto pushOrShed = [&](JobQueue (&jobs)[kNumPriorities]) {
+			if (m_maxQueuedJobs != 0 && NumQueuedJobs() >= m_maxQueuedJobs && !ShedOldest(jobs, lane, shed)
+				&& job.IsCancellable()) {
+				shed = std::move(job);
+				return false;
+			}
+			jobs[lane].Push(std::move(job));
+			m_numQueuedJobs[lane].fetch_add(1);
+			return true;
+		};
+
+		if (m_mode == SchedulingMode::GlobalQueue) {
+			bool pushed;
+			{
+				std::lock_guard<std::mutex> lock(m_mutexForJobs);
+				pushed = pushOrShed(m_jobs);
+			}
+			if (shed)
+				CancelJob(shed, CancelReason::Shed);
+			// 잠든 worker 가 없으면 notify(syscall) 생략. (spin 중인 worker 는 개수 변화를 직접 본다)
+			if (pushed && m_numSleeping.load() > 0)
+				m_cvForJobs.notify_one();
+			return;
+		}
+
+		// worker 가 만든 작업은 자기 deque 에, 외부 쓰레드는 round-robin 으로 분산.
+		const size_t target = (s_currentPool == this)
+			? s_workerIndex
+			: m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_numThread;
+		bool pushed;
+		{
+			WorkerQueue& queue = m_workerQueues[target];
+			std::lock_guard<FutexMutex> lock(queue.mutex);
+			pushed = pushOrShed(queue.jobs);
+			queue.UpdateDepth();
+		}
+		if (shed)
+			CancelJob(shed, CancelReason::Shed);
+
+		// 자고 있는 worker 가 없으면 mutex/notify 비용을 생략.
+		if (pushed && m_numSleeping.load() > 0) {
+			{ std::lock_guard<std::mutex> lock(m_mutexForJobs); }
+			m_cvForJobs.notify_one();
+		}
+	}
+
+	inline void ThreadPool::PushJobs(std::vector<Job>& jobs, Priority priority)
+	{
+		const size_t lane = static_cast<size_t>(priority);
+		const size_t count = jobs.size();
+		if (count == 0)
+			return;
+		if (m_maxQueuedJobs != 0) {
+			// 버릴 작업을 하나씩 골라야 하므로 개별로 넣는다.
+			for (Job& job : jobs) PushJob(std::move(job), priority);
+			return;
+		}
+		if (m_queueWaitMetrics.load(std::memory_order_relaxed)) {
+			const auto now = std::chrono::steady_clock::now();
+			for (Job& job : jobs) job.SetEnqueueTime(now);
+		}
+
+		if (m_mode == SchedulingMode::GlobalQueue) {
+			std::lock_guard<std::mutex> lock(m_mutexForJobs);
+			for (Job& job : jobs) m_jobs[lane].Push(std::move(job));
+			m_numQueuedJobs[lane].fetch_add(count);
+		}
+		else {
+			// worker 수만큼 연속된 조각으로 나눠 deque 마다 lock 한 번에 넣는다.
+			// 조각마다 개수를 바로 알려서 spin 중인 worker 는 나머지를 넣는 동안 시작할 수 있다.
+			const size_t numTargets = std::min(count, m_numThread);
+			const size_t start = m_nextQueue.fetch_add(numTargets, std::memory_order_relaxed);
+			size_t begin = 0;
+			for (size_t t = 0; t < numTargets; ++t) {
+				const size_t end = count * (t + 1) / numTargets;
+				WorkerQueue& queue = m_workerQueues[(start + t) % m_numThread];
+				{
+					std::lock_guard<FutexMutex> lock(queue.mutex);
+					for (size_t i = begin; i < end; ++i) queue.jobs[lane].Push(std::move(jobs[i]));
+					queue.UpdateDepth();
+				}
+				m_numQueuedJobs[lane].fetch_add(end - begin);
+				begin = end;
+			}
+		}
+		WakeWorkers(count);
+	}
+
+	// 잠든 worker 를 최대 count 개 깨운다. (모두 깨워야 하면 notify_all 한 번)
+	inline void ThreadPool::WakeWorkers(size_t count)
+	{
+		const size_t sleeping = m_numSleeping.load();
+		if (sleeping == 0)
+			return;
+		if (m_mode == SchedulingMode::WorkStealing) {
+			// PushJob 과 같은 이유로 대기 조건 검사와 wait 사이에 끼어들지 않게 한다.
+			std::lock_guard<std::mutex> lock(m_mutexForJobs);
+		}
+		if (count >= sleeping) {
+			m_cvForJobs.notify_all();
+			return;
+		}
+		for (size_t i = 0; i < count; ++i) m_cvForJobs.notify_one();
+	}
+
+	inline bool ThreadPool::PopLocalJob(size_t index, size_t lane, Job& job)
+	{
+		WorkerQueue& queue = m_workerQueues[index];
+		std::lock_guard<FutexMutex> lock(queue.mutex);
+		if (queue.jobs[lane].Empty())
+			return false;
+		job = queue.jobs[lane].PopBack();
+		queue.UpdateDepth();
+		m_numQueuedJobs[lane].fetch_sub(1);
+		return true;
+	}
+
+	inline bool ThreadPool::StealJob(size_t index, size_t lane, Job& job)
+	{
+		for (size_t victimIndex : m_stealOrder[index]) {
+			WorkerQueue& victim = m_workerQueues[victimIndex];
+			std::lock_guard<FutexMutex> lock(victim.mutex);
+			if (victim.jobs[lane].Empty())
+				continue;
+			job = victim.jobs[lane].PopFront();
+			victim.UpdateDepth();
+			m_numQueuedJobs[lane].fetch_sub(1);
+			if (m_workerStats)
+				WorkerMetrics::Add(m_workerMetrics[index].steals, uint64_t(1));
+			return true;
+		}
+		return false;
+	}
+
+	inline Histogram ThreadPool::GetQueueWaitLatency(Priority priority) const
+	{
+		Histogram snapshot;
+		for (size_t i = 0; i < m_numThread; ++i)
+			snapshot.Merge(m_workerMetrics[i].queueWait[static_cast<size_t>(priority)].Snapshot());
+		return snapshot;
+	}
+
+	inline ThreadPoolStats ThreadPool::Snapshot() const
+	{
+		ThreadPoolStats stats;
+		const int64_t now = NowNs();
+		stats.workers.resize(m_numThread);
+		for (size_t i = 0; i < m_numThread; ++i) {
+			const WorkerMetrics& metrics = m_workerMetrics[i];
+			WorkerStats& worker = stats.workers[i];
+			worker.jobsExecuted = metrics.jobsExecuted.load(std::memory_order_relaxed);
+			worker.steals = metrics.steals.load(std::memory_order_relaxed);
+			worker.parks = metrics.parks.load(std::memory_order_relaxed);
+			worker.cpu = GetWorkerCpu(i);
+			if (m_workerQueues)
+				worker.queueDepth = m_workerQueues[i].depth.load(std::memory_order_relaxed);
+
+			const int64_t start = metrics.startNs.load(std::memory_order_relaxed);
+			if (start != 0) {
+				// idleNs 를 먼저 읽는다. 갱신된 idleNs 를 봤다면 idleSinceNs 는 이미 0 이다. (두 번 세지 않음)
+				int64_t idle = metrics.idleNs.load(std::memory_order_acquire);
+				const int64_t idleSince = metrics.idleSinceNs.load(std::memory_order_relaxed);
+				if (idleSince != 0 && now > idleSince)
+					idle += now - idleSince;
+				const int64_t elapsed = std::max<int64_t>(now - start, 0);
+				idle = std::min(idle, elapsed);
+				worker.idleTime = std::chrono::nanoseconds(idle);
+				worker.busyTime = std::chrono::nanoseconds(elapsed - idle);
+			}
+			for (size_t lane = 0; lane < kNumPriorities; ++lane)
+				stats.queueWait[lane].Merge(metrics.queueWait[lane].Snapshot());
+		}
+		for (size_t lane = 0; lane < kNumPriorities; ++lane)
+			stats.queuedJobs[lane] = m_numQueuedJobs[lane].load(std::memory_order_relaxed);
+		for (size_t reason = 0; reason < kNumCancelReasons; ++reason)
+			stats.cancelled[reason] = m_numCancelled[reason].load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	inline void ThreadPool::ResetQueueWaitLatency()
+	{
+		for (size_t i = 0; i < m_numThread; ++i) {
+			for (auto& histogram : m_workerMetrics[i].queueWait) histogram.Reset();
+		}
+	}
+
+	template <class F, class... Args>
+		requires (!std::is_same_v<std::decay_t<F>, JobOptions>)
+	std::future<std::invoke_result_t<F, Args...>>
+		ThreadPool::EnqueueJob(F&& f, Args&&... args)
+	{
+		return EnqueueJob(Priority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+	template <class F, class... Args>
+	std::future<std::invoke_result_t<F, Args...>>
+		ThreadPool::EnqueueJob(Priority priority, F&& f, Args&&... args)
+	{
+		if (m_stopAll) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+
+		using ReturnType = std::invoke_result_t<F, Args...>;
+
+		// packaged_task + shared_ptr + bind + std::function 대신
+		// promise 를 직접 Job 에 담는다. (promise 의 shared state 는 BlockPool 에서 할당)
+		std::promise<ReturnType> promise(std::allocator_arg, PoolAllocator<ReturnType>());
+		std::future<ReturnType> job_result_future = promise.get_future();
+
+		// std::bind 와 같이 인자는 lvalue 로 전달.
+		auto call = [f = std::forward<F>(f), ...args = std::forward<Args>(args)]() mutable -> ReturnType {
+			return std::invoke(f, args...);
+		};
+		PushJob(detail::PromiseTask<ReturnType, decltype(call)>{ std::move(promise), std::move(call) }, priority);
+
+		return job_result_future;
+	}
+
+	template <class F>
+	void ThreadPool::Post(F&& f)
+	{
+		Post(Priority::Normal, std::forward<F>(f));
+	}
+
+	template <class F>
+	void ThreadPool::Post(Priority priority, F&& f)
+	{
+		if (m_stopAll) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+		PushJob(Job(std::forward<F>(f)), priority);
+	}
+
+	template <class Done>
+	void ThreadPool::HelpUntil(Done&& done)
+	{
+		const bool isWorker = GetCurrentWorkerIndex() != kNotWorker;
+		uint32_t idle = 0;
+		while (!done())
+		{
+			if (isWorker && TryRunPendingJob()) {
+				idle = 0;
+				continue;
+			}
+			// 기다리는 결과는 다른 쓰레드가 만드는 중이다.
+			if (++idle < 64)
+				CpuRelax();
+			else if (idle < 128)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+
+	template <class T>
+	T ThreadPool::Await(std::future<T>& future)
+	{
+		if (GetCurrentWorkerIndex() != kNotWorker) {
+			HelpUntil([&future]() { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+		}
+		return future.get();
+	}
+
+	inline TimerWheel* ThreadPool::Timers(bool create)
+	{
+		std::lock_guard<std::mutex> lock(m_timersMutex);
+		if (!m_timers && create && !m_timersClosed && !m_stopAll)
+			m_timers = std::make_unique<TimerWheel>();
+		return m_timers.get();
+	}
+
+	template <class F>
+	TimerId ThreadPool::EnqueueAfter(std::chrono::nanoseconds delay, F&& f, Priority priority)
+	{
+		if (m_stopAll) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+		TimerWheel* timers = Timers(true);
+		if (!timers) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+		return timers->Schedule(delay, [this, priority, f = std::forward<F>(f)]() mutable {
+			PushJob(Job(std::move(f)), priority);
+		});
+	}
+
+	template <class F>
+	TimerId ThreadPool::EnqueueEvery(std::chrono::nanoseconds period, F&& f, Priority priority)
+	{
+		if (m_stopAll) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+		// 실행이 겹칠 수 있으므로 callable 은 실행마다 공유한다.
+		TimerWheel* timers = Timers(true);
+		if (!timers) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+		auto shared = std::make_shared<std::decay_t<F>>(std::forward<F>(f));
+		return timers->Schedule(period, [this, priority, shared = std::move(shared)]() {
+			PushJob(Job([shared]() { (*shared)(); }), priority);
+		}, period);
+	}
+
+	template <class It>
+	BulkHandle ThreadPool::EnqueueBulk(It first, It last, Priority priority)
+	{
+		if (m_stopAll) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+
+		// lock 밖에서 Job 을 모두 만들어 두고 한 번에 넣는다.
+		auto state = std::make_unique<detail::BulkState>();
+		std::vector<Job> jobs;
+		if constexpr (std::forward_iterator<It>)
+			jobs.reserve(static_cast<size_t>(std::distance(first, last)));
+		for (; first != last; ++first) {
+			using F = std::decay_t<decltype(*first)>;
+			// 작업을 만들기 전에 센다. (만들다 예외가 나서 파괴되어도 Done 과 짝이 맞도록)
+			state->waitGroup.Add();
+			jobs.emplace_back(detail::BulkTask<F>(state.get(), *first));
+		}
+
+		state->size = jobs.size();
+		PushJobs(jobs, priority);
+		state->waitGroup.Done(); // 제출하는 쪽 몫
+		return BulkHandle(std::move(state));
+	}
+
+	template <class F, class... Args>
+	std::future<detail::TokenInvokeResult<F, Args...>>
+		ThreadPool::EnqueueJob(const JobOptions& options, F&& f, Args&&... args)
+	{
+		if (m_stopAll) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+
+		using ReturnType = detail::TokenInvokeResult<F, Args...>;
+
+		detail::CancelCondition condition{ options.stopToken.stop_possible() ? options.stopToken : GetStopToken() };
+		if (options.timeout.count() > 0)
+			condition.deadline = std::chrono::steady_clock::now() + options.timeout;
+
+		std::promise<ReturnType> promise(std::allocator_arg, PoolAllocator<ReturnType>());
+		std::future<ReturnType> job_result_future = promise.get_future();
+
+		auto call = [f = std::forward<F>(f), ...args = std::forward<Args>(args), token = condition.token]() mutable -> ReturnType {
+			return detail::InvokeWithToken(token, f, args...);
+		};
+		PushJob(detail::CancellableTask<ReturnType, decltype(call)>{
+			{ std::move(promise), std::move(call) }, std::move(condition) }, options.priority);
+
+		return job_result_future;
+	}
+
+	template <class F>
+	void ThreadPool::Post(const JobOptions& options, F&& f)
+	{
+		if (m_stopAll) {
+			throw std::runtime_error("ThreadPool 사용 중지됨");
+		}
+
+		detail::CancelCondition condition{ options.stopToken.stop_possible() ? options.stopToken : GetStopToken() };
+		if (options.timeout.count() > 0)
+			condition.deadline = std::chrono::steady_clock::now() + options.timeout;
+
+		auto call = [f = std::forward<F>(f)](std::stop_token token) mutable {
+			detail::InvokeWithToken(std::move(token), f);
+		};
+		PushJob(detail::CancellablePost<decltype(call)>{ std::move(condition), std::move(call) }, options.priority);
+	}
+
+}  // namespace ThreadPool
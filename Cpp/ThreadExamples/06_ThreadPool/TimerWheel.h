@@ -0,0 +1,339 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Job.h"
+
+namespace ThreadPool
+{
+	// TimerWheel::Schedule 가 돌려주는 타이머 번호. (취소용)
+	struct TimerId
+	{
+		uint32_t index{ UINT32_MAX };
+		uint32_t generation{ 0 };
+
+		explicit operator bool() const { return index != UINT32_MAX; }
+	};
+
+	// 계층형 timing wheel + 타이머 쓰레드 하나.
+	// - 시간을 resolution 단위 tick 으로 나누고, 64 칸짜리 wheel 4 단에 만료 tick 별로 나눠 담는다.
+	//   0 단은 1 tick 간격, k 단은 64^k tick 간격. 위 단의 칸은 차례가 오면 아래 단으로 다시 나눠 담는다(cascade).
+	// - 등록 / 취소는 칸의 이중 연결 list 에 넣고 빼기만 하므로 O(1). (타이머 수와 무관)
+	// - 64^4 tick(1ms 기준 약 4.6 시간) 보다 먼 타이머는 맨 위 단 끝에 두었다가 cascade 때 다시 계산한다.
+	// - 칸마다 점유 bit 를 두어, 할 일이 있는 다음 tick 까지는 잠들어 있다.
+	// - 만료된 callback 은 lock 밖에서, 타이머 쓰레드에서 실행된다. (짧게: ThreadPool 은 작업을 넣기만 함)
+	class TimerWheel
+	{
+	public:
+		explicit TimerWheel(std::chrono::nanoseconds resolution = std::chrono::milliseconds(1))
+			: m_resolution(std::max(resolution, std::chrono::nanoseconds(1)))
+			, m_start(std::chrono::steady_clock::now())
+		{
+			for (auto& level : m_slots) std::fill(std::begin(level), std::end(level), kNil);
+			m_thread = std::thread([this]() { Loop(); });
+		}
+
+		~TimerWheel() { Stop(); }
+
+		TimerWheel(const TimerWheel&) = delete;
+		TimerWheel& operator=(const TimerWheel&) = delete;
+
+		// delay 뒤에 f 를 실행한다. period 가 0 이 아니면 그 뒤로 period 마다 반복.
+		// 만료 시각은 tick 단위로 올림 (일찍 실행되지는 않음)
+		template <class F>
+		TimerId Schedule(std::chrono::nanoseconds delay, F&& f, std::chrono::nanoseconds period = std::chrono::nanoseconds(0))
+		{
+			Job callback(std::forward<F>(f));
+			const uint64_t expiry = TickAt(std::chrono::steady_clock::now() + delay, true);
+			const uint64_t periodTicks = period.count() > 0 ? std::max<uint64_t>(1, (period.count() + m_resolution.count() - 1) / m_resolution.count()) : 0;
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_stop)
+				return {};
+			// 비어 있는 동안 멈춰 있던 m_now 를 현재로 당긴다. (칸 위치가 m_now 기준이므로 비었을 때만)
+			if (m_numTimers == 0)
+				m_now = std::max(m_now, TickAt(std::chrono::steady_clock::now(), false));
+			const uint32_t index = AllocateNode();
+			Node& node = GetNode(index);
+			node.callback = std::move(callback);
+			node.expiry = std::max(expiry, m_now + 1);
+			node.period = periodTicks;
+			node.state = State::Pending;
+			node.cancelled = false;
+			Insert(index);
+			++m_numTimers;
+
+			// 타이머 쓰레드가 이보다 늦게 일어날 예정이면 깨운다.
+			const bool wake = node.expiry < m_wakeTick;
+			const TimerId id{ index, node.generation };
+			lock.unlock();
+			if (wake)
+				m_cv.notify_one();
+			return id;
+		}
+
+		// 아직 실행되지 않은 타이머를 취소한다. 취소했으면 true.
+		// 반복 타이머는 지금 실행 중이어도 다음 실행부터 멈추고 true.
+		bool Cancel(TimerId id)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!id || id.index >= m_numNodes)
+				return false;
+			Node& node = GetNode(id.index);
+			if (node.generation != id.generation)
+				return false;
+			if (node.state == State::Pending) {
+				Unlink(id.index);
+				FreeNode(id.index);
+				--m_numTimers;
+				return true;
+			}
+			if (node.state == State::Firing && node.period != 0 && !node.cancelled) {
+				node.cancelled = true;
+				return true;
+			}
+			return false;
+		}
+
+		// 등록되어 있는 타이머 수 (실행 중인 반복 타이머 포함)
+		size_t Size() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_numTimers;
+		}
+
+		std::chrono::nanoseconds Resolution() const { return m_resolution; }
+
+		// 타이머 쓰레드를 멈춘다. 남은 타이머는 실행하지 않고 버린다.
+		void Stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_cv.notify_all();
+			if (m_thread.joinable())
+				m_thread.join();
+		}
+
+	private:
+		static constexpr int kSlotBits = 6;
+		static constexpr size_t kNumSlots = size_t(1) << kSlotBits;
+		static constexpr int kNumLevels = 4;
+		static constexpr uint32_t kNil = UINT32_MAX;
+		static constexpr size_t kChunkSize = 4096; // node 를 이 개수씩 할당 (주소가 바뀌지 않도록)
+
+		enum class State : uint8_t { Free, Pending, Firing };
+
+		struct Node
+		{
+			Job callback;
+			uint64_t expiry{ 0 };
+			uint64_t period{ 0 }; // tick, 0 이면 한 번
+			uint32_t prev{ kNil };
+			uint32_t next{ kNil };
+			uint32_t generation{ 0 };
+			uint8_t level{ 0 };
+			uint8_t slot{ 0 };
+			State state{ State::Free };
+			bool cancelled{ false };
+		};
+
+		uint64_t TickAt(std::chrono::steady_clock::time_point time, bool roundUp) const
+		{
+			const auto since = std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_start).count();
+			if (since <= 0)
+				return 0;
+			const auto tick = since / m_resolution.count();
+			return static_cast<uint64_t>(roundUp && since % m_resolution.count() ? tick + 1 : tick);
+		}
+
+		std::chrono::steady_clock::time_point TimeOf(uint64_t tick) const
+		{
+			return m_start + m_resolution * static_cast<int64_t>(tick);
+		}
+
+		Node& GetNode(uint32_t index) { return m_chunks[index / kChunkSize][index % kChunkSize]; }
+
+		uint32_t AllocateNode()
+		{
+			if (m_freeHead != kNil) {
+				const uint32_t index = m_freeHead;
+				m_freeHead = GetNode(index).next;
+				return index;
+			}
+			if (m_numNodes % kChunkSize == 0)
+				m_chunks.push_back(std::make_unique<Node[]>(kChunkSize));
+			return m_numNodes++;
+		}
+
+		void FreeNode(uint32_t index)
+		{
+			Node& node = GetNode(index);
+			node.callback.Reset();
+			node.state = State::Free;
+			++node.generation; // 남아 있는 TimerId 무효화
+			node.next = m_freeHead;
+			m_freeHead = index;
+		}
+
+		// 만료 tick 과 현재 tick 의 차이로 단과 칸을 정한다.
+		void Insert(uint32_t index)
+		{
+			Node& node = GetNode(index);
+			const uint64_t delta = node.expiry - m_now;
+			int level = 0;
+			while (level < kNumLevels - 1 && delta >= (uint64_t(1) << (kSlotBits * (level + 1))))
+				++level;
+			// 맨 위 단으로도 부족하면 그 단의 가장 먼 칸에 둔다. (cascade 때 다시 계산)
+			const uint64_t maxDelta = (uint64_t(1) << (kSlotBits * kNumLevels)) - 1;
+			const uint64_t placeAt = delta > maxDelta ? m_now + maxDelta : node.expiry;
+			const size_t slot = (placeAt >> (kSlotBits * level)) & (kNumSlots - 1);
+
+			node.level = static_cast<uint8_t>(level);
+			node.slot = static_cast<uint8_t>(slot);
+			node.prev = kNil;
+			node.next = m_slots[level][slot];
+			if (node.next != kNil)
+				GetNode(node.next).prev = index;
+			m_slots[level][slot] = index;
+			m_occupied[level] |= uint64_t(1) << slot;
+		}
+
+		void Unlink(uint32_t index)
+		{
+			Node& node = GetNode(index);
+			if (node.prev != kNil)
+				GetNode(node.prev).next = node.next;
+			else
+				m_slots[node.level][node.slot] = node.next;
+			if (node.next != kNil)
+				GetNode(node.next).prev = node.prev;
+			if (m_slots[node.level][node.slot] == kNil)
+				m_occupied[node.level] &= ~(uint64_t(1) << node.slot);
+		}
+
+		// 칸을 통째로 떼어 낸다. (첫 node 번호, list 는 next 로 연결된 채)
+		uint32_t TakeSlot(int level, size_t slot)
+		{
+			const uint32_t head = m_slots[level][slot];
+			m_slots[level][slot] = kNil;
+			m_occupied[level] &= ~(uint64_t(1) << slot);
+			return head;
+		}
+
+		// 할 일이 있는 다음 tick: 0 단의 다음 점유 칸, 없으면 0 단이 한 바퀴 도는 tick (cascade)
+		uint64_t NextEventTick() const
+		{
+			const size_t index = m_now & (kNumSlots - 1);
+			const uint64_t ahead = index + 1 < kNumSlots ? m_occupied[0] & (~uint64_t(0) << (index + 1)) : 0;
+			if (ahead)
+				return (m_now & ~uint64_t(kNumSlots - 1)) + std::countr_zero(ahead);
+			return (m_now | (kNumSlots - 1)) + 1;
+		}
+
+		// m_now 를 1 tick 진행하고, 만료된 node 를 firing list 로 모은다.
+		uint32_t Advance()
+		{
+			++m_now;
+			// 0 단이 한 바퀴 돌았으면 위 단의 현재 칸을 아래로 다시 나눠 담는다. (위 단도 한 바퀴면 그 위도)
+			for (int level = 1; level < kNumLevels; ++level) {
+				if ((m_now & ((uint64_t(1) << (kSlotBits * level)) - 1)) != 0)
+					break;
+				const size_t slot = (m_now >> (kSlotBits * level)) & (kNumSlots - 1);
+				for (uint32_t index = TakeSlot(level, slot); index != kNil;) {
+					const uint32_t next = GetNode(index).next;
+					Insert(index);
+					index = next;
+				}
+			}
+
+			uint32_t firing = TakeSlot(0, m_now & (kNumSlots - 1));
+			for (uint32_t index = firing; index != kNil; index = GetNode(index).next)
+				GetNode(index).state = State::Firing;
+			return firing;
+		}
+
+		void Loop()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (!m_stop) {
+				if (m_numTimers == 0) {
+					m_wakeTick = UINT64_MAX;
+					m_cv.wait(lock, [this]() { return m_stop || m_numTimers > 0; });
+					continue;
+				}
+
+				const uint64_t next = NextEventTick();
+				if (next > TickAt(std::chrono::steady_clock::now(), false)) {
+					m_wakeTick = next;
+					m_cv.wait_until(lock, TimeOf(next));
+					continue;
+				}
+				m_wakeTick = 0; // 일하는 중에는 Schedule 이 깨우지 않아도 된다.
+
+				m_now = next - 1;
+				const uint32_t firing = Advance();
+				if (firing == kNil)
+					continue;
+
+				// callback 은 lock 밖에서. (그동안 Cancel 은 cancelled 표시만 한다)
+				// m_chunks 는 Schedule 이 늘릴 수 있으므로 node 주소를 미리 모아 둔다. (node 자체는 옮겨지지 않음)
+				m_firing.clear();
+				for (uint32_t index = firing; index != kNil; index = GetNode(index).next)
+					m_firing.push_back({ index, &GetNode(index) });
+				lock.unlock();
+				for (auto& [index, node] : m_firing)
+					node->callback();
+				lock.lock();
+
+				for (auto& [index, nodePtr] : m_firing) {
+					Node& node = *nodePtr;
+					if (node.period != 0 && !node.cancelled && !m_stop) {
+						// 밀려서 지난 주기는 건너뛴다. (한꺼번에 몰아서 실행하지 않음)
+						node.expiry += node.period;
+						if (node.expiry <= m_now)
+							node.expiry = m_now + node.period - (m_now - node.expiry) % node.period;
+						node.state = State::Pending;
+						Insert(index);
+					}
+					else {
+						FreeNode(index);
+						--m_numTimers;
+					}
+				}
+			}
+		}
+
+		const std::chrono::nanoseconds m_resolution;
+		const std::chrono::steady_clock::time_point m_start;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_cv;
+		bool m_stop{ false };
+
+		uint64_t m_now{ 0 };             // 처리를 마친 tick
+		uint64_t m_wakeTick{ UINT64_MAX }; // 타이머 쓰레드가 일어날 예정인 tick
+		uint32_t m_slots[kNumLevels][kNumSlots];
+		uint64_t m_occupied[kNumLevels]{};
+		size_t m_numTimers{ 0 };
+
+		std::vector<std::unique_ptr<Node[]>> m_chunks;
+		std::vector<std::pair<uint32_t, Node*>> m_firing; // 타이머 쓰레드만 사용
+		uint32_t m_numNodes{ 0 };
+		uint32_t m_freeHead{ kNil };
+
+		std::thread m_thread; // 마지막에 생성 (위의 멤버를 사용)
+	};
+
+}  // namespace ThreadPool
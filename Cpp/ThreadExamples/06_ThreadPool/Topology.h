@@ -0,0 +1,289 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ThreadPool
+{
+	// 논리 CPU 하나의 위치.
+	struct LogicalCpu
+	{
+		uint32_t id;      // OS 의 CPU 번호
+		uint32_t package; // socket
+		uint32_t core;    // 물리 core (SMT 형제는 같은 값)
+		uint32_t l3;      // L3 를 공유하는 CPU 묶음의 번호 (묶음 중 가장 작은 CPU 번호)
+	};
+
+	// worker 를 CPU 에 배치하는 방법
+	enum class Placement
+	{
+		None,    // 고정하지 않음 (OS 가 자유롭게 옮김)
+		Compact, // 한 L3 묶음을 먼저 채운다. (worker 끼리 cache 공유, 데이터 주고받기 유리)
+		Spread,  // L3 묶음/socket 에 고르게 나눈다. (전체 cache 용량, memory 대역폭 유리)
+	};
+
+	// CPU 구성 정보.
+	// - Linux: /sys/devices/system/cpu 에서 읽는다.
+	// - Windows: GetLogicalProcessorInformation (processor group 0, 64 개까지)
+	// - 읽지 못하면 socket 1개, L3 1개, CPU 마다 core 1개로 본다.
+	class CpuTopology
+	{
+	public:
+		static CpuTopology Detect()
+		{
+			CpuTopology topology;
+#if defined(_WIN32)
+			topology.DetectWindows();
+#elif defined(__linux__)
+			topology.DetectLinux();
+#endif
+			if (topology.m_cpus.empty())
+				topology.DetectFallback();
+			std::sort(topology.m_cpus.begin(), topology.m_cpus.end(), [](const LogicalCpu& a, const LogicalCpu& b) {
+				return std::tie(a.package, a.l3, a.core, a.id) < std::tie(b.package, b.l3, b.core, b.id);
+			});
+			return topology;
+		}
+
+		const std::vector<LogicalCpu>& Cpus() const { return m_cpus; }
+		size_t L3SizeBytes() const { return m_l3SizeBytes; } // 모르면 0
+
+		size_t NumPackages() const { return CountDistinct(&LogicalCpu::package); }
+		size_t NumL3Domains() const { return CountDistinct(&LogicalCpu::l3); }
+
+		// numThread 개 worker 가 차례로 쓸 CPU. (CPU 보다 worker 가 많으면 처음부터 다시 돈다)
+		std::vector<LogicalCpu> Plan(Placement placement, size_t numThread) const
+		{
+			std::vector<LogicalCpu> order;
+			if (placement == Placement::None || m_cpus.empty())
+				return order;
+
+			if (placement == Placement::Compact) {
+				order = m_cpus; // (package, l3, core, id) 순서 그대로
+			}
+			else {
+				// L3 묶음마다 "core 별 첫 번째 CPU → 두 번째 CPU(SMT)" 순서로 줄을 세운 뒤,
+				// 묶음들을 번갈아 가며 하나씩 꺼낸다.
+				std::map<std::pair<uint32_t, uint32_t>, std::vector<LogicalCpu>> domains;
+				for (const LogicalCpu& cpu : m_cpus)
+					domains[{ cpu.package, cpu.l3 }].push_back(cpu);
+				std::vector<std::vector<LogicalCpu>> queues;
+				for (auto& [key, cpus] : domains) {
+					std::vector<LogicalCpu> firstThreads;
+					std::vector<LogicalCpu> siblings;
+					std::set<uint32_t> seenCores;
+					for (const LogicalCpu& cpu : cpus)
+						(seenCores.insert(cpu.core).second ? firstThreads : siblings).push_back(cpu);
+					firstThreads.insert(firstThreads.end(), siblings.begin(), siblings.end());
+					queues.push_back(std::move(firstThreads));
+				}
+				for (size_t i = 0; order.size() < m_cpus.size(); ++i) {
+					for (auto& queue : queues) {
+						if (i < queue.size())
+							order.push_back(queue[i]);
+					}
+				}
+			}
+
+			std::vector<LogicalCpu> plan;
+			plan.reserve(numThread);
+			for (size_t i = 0; i < numThread; ++i)
+				plan.push_back(order[i % order.size()]);
+			return plan;
+		}
+
+	private:
+		size_t CountDistinct(uint32_t LogicalCpu::* field) const
+		{
+			std::set<uint32_t> values;
+			for (const LogicalCpu& cpu : m_cpus) values.insert(cpu.*field);
+			return values.size();
+		}
+
+		void DetectFallback()
+		{
+			const uint32_t count = std::max(std::thread::hardware_concurrency(), 1u);
+			for (uint32_t i = 0; i < count; ++i)
+				m_cpus.push_back({ i, 0, i, 0 });
+		}
+
+#if defined(_WIN32)
+		void DetectWindows()
+		{
+			DWORD length = 0;
+			GetLogicalProcessorInformation(nullptr, &length);
+			std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+			if (infos.empty() || !GetLogicalProcessorInformation(infos.data(), &length))
+				return;
+
+			constexpr uint32_t kMaxCpus = sizeof(ULONG_PTR) * 8;
+			uint32_t core[kMaxCpus] = {};
+			uint32_t package[kMaxCpus] = {};
+			uint32_t l3[kMaxCpus] = {};
+			ULONG_PTR present = 0;
+			uint32_t coreIndex = 0;
+			uint32_t packageIndex = 0;
+			auto lowestBit = [](ULONG_PTR mask) {
+				uint32_t bit = 0;
+				while (bit < kMaxCpus && !(mask & (ULONG_PTR(1) << bit))) ++bit;
+				return bit;
+			};
+
+			for (const auto& info : infos) {
+				const ULONG_PTR mask = info.ProcessorMask;
+				for (uint32_t cpu = 0; cpu < kMaxCpus; ++cpu) {
+					if (!(mask & (ULONG_PTR(1) << cpu)))
+						continue;
+					switch (info.Relationship) {
+					case RelationProcessorCore: core[cpu] = coreIndex; present |= ULONG_PTR(1) << cpu; break;
+					case RelationProcessorPackage: package[cpu] = packageIndex; break;
+					case RelationCache:
+						if (info.Cache.Level == 3) l3[cpu] = lowestBit(mask);
+						break;
+					default: break;
+					}
+				}
+				if (info.Relationship == RelationProcessorCore) ++coreIndex;
+				if (info.Relationship == RelationProcessorPackage) ++packageIndex;
+				if (info.Relationship == RelationCache && info.Cache.Level == 3)
+					m_l3SizeBytes = info.Cache.Size;
+			}
+			for (uint32_t cpu = 0; cpu < kMaxCpus; ++cpu) {
+				if (present & (ULONG_PTR(1) << cpu))
+					m_cpus.push_back({ cpu, package[cpu], core[cpu], l3[cpu] });
+			}
+		}
+#elif defined(__linux__)
+		static std::string ReadLine(const std::string& path)
+		{
+			std::ifstream file(path);
+			std::string line;
+			std::getline(file, line);
+			return line;
+		}
+
+		// "0-3,8-11" 형식
+		static std::vector<uint32_t> ParseCpuList(const std::string& text)
+		{
+			std::vector<uint32_t> cpus;
+			size_t pos = 0;
+			while (pos < text.size()) {
+				size_t end = text.find(',', pos);
+				if (end == std::string::npos) end = text.size();
+				const std::string range = text.substr(pos, end - pos);
+				const size_t dash = range.find('-');
+				try {
+					const uint32_t first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+					const uint32_t last = dash == std::string::npos ? first : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+					for (uint32_t cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+				}
+				catch (...) {
+					return {};
+				}
+				pos = end + 1;
+			}
+			return cpus;
+		}
+
+		// "32768K" 형식
+		static size_t ParseSize(const std::string& text)
+		{
+			try {
+				size_t size = std::stoul(text);
+				if (text.find('K') != std::string::npos) size *= 1024;
+				else if (text.find('M') != std::string::npos) size *= 1024 * 1024;
+				return size;
+			}
+			catch (...) {
+				return 0;
+			}
+		}
+
+		void DetectLinux()
+		{
+			const std::string root = "/sys/devices/system/cpu/";
+			for (uint32_t id : ParseCpuList(ReadLine(root + "online"))) {
+				const std::string cpuDir = root + "cpu" + std::to_string(id) + "/";
+				LogicalCpu cpu{ id, 0, id, 0 };
+				try {
+					cpu.package = static_cast<uint32_t>(std::stoul(ReadLine(cpuDir + "topology/physical_package_id")));
+					// core_id 는 socket 안에서만 유일하므로 SMT 형제 중 가장 작은 번호를 core 번호로 쓴다.
+					const auto siblings = ParseCpuList(ReadLine(cpuDir + "topology/thread_siblings_list"));
+					if (!siblings.empty()) cpu.core = siblings.front();
+				}
+				catch (...) {}
+
+				// L3 가 없으면(또는 읽지 못하면) socket 을 L3 묶음으로 본다. (CPU 번호와 겹치지 않게 최상위 bit 표시)
+				cpu.l3 = 0x80000000u | cpu.package;
+				for (int index = 0; index < 8; ++index) {
+					const std::string cacheDir = cpuDir + "cache/index" + std::to_string(index) + "/";
+					if (ReadLine(cacheDir + "level") != "3")
+						continue;
+					const auto shared = ParseCpuList(ReadLine(cacheDir + "shared_cpu_list"));
+					if (!shared.empty()) cpu.l3 = shared.front();
+					m_l3SizeBytes = ParseSize(ReadLine(cacheDir + "size"));
+					break;
+				}
+				m_cpus.push_back(cpu);
+			}
+		}
+#endif
+
+		std::vector<LogicalCpu> m_cpus;
+		size_t m_l3SizeBytes{ 0 };
+	};
+
+	// 현재 쓰레드를 cpu 하나에 고정한다. 실패하면 false.
+	inline bool PinCurrentThread(uint32_t cpu)
+	{
+#if defined(_WIN32)
+		if (cpu >= sizeof(DWORD_PTR) * 8)
+			return false;
+		return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		(void)cpu;
+		return false;
+#endif
+	}
+
+	// 현재 쓰레드의 OS 쓰레드 id. (Linux 는 perf_event_open 등에 넘기는 tid) 지원하지 않으면 0.
+	inline int CurrentOsThreadId()
+	{
+#if defined(_WIN32)
+		return static_cast<int>(GetCurrentThreadId());
+#elif defined(__linux__)
+		return static_cast<int>(syscall(SYS_gettid));
+#else
+		return 0;
+#endif
+	}
+
+}  // namespace ThreadPool
@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace ThreadPool
+{
+	// 끝나지 않은 작업 수를 세다가 0 이 되면 Wait() 중인 쓰레드를 깨운다.
+	// - Done() 은 atomic 감소만 하고, 마지막 하나만 mutex 를 잡는다.
+	// - notify 를 lock 안에서 하므로 Wait() 가 돌아온 뒤 바로 파괴해도 안전.
+	class WaitGroup
+	{
+	public:
+		WaitGroup() = default;
+		explicit WaitGroup(size_t count) : m_count(count) {}
+
+		void Add(size_t count = 1) { m_count.fetch_add(count, std::memory_order_relaxed); }
+
+		void Done()
+		{
+			if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_done = true;
+				m_cv.notify_all();
+			}
+		}
+
+		void Wait()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [this]() { return m_done; });
+		}
+
+		// lock 없이 확인. (true 를 본 뒤에도 파괴 전에는 Wait() 를 불러 Done() 이 끝나기를 기다릴 것)
+		bool IsDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+	private:
+		std::atomic<size_t> m_count{ 0 };
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		bool m_done{ false };
+	};
+
+}  // namespace ThreadPool
@@ -12,6 +12,8 @@
 #include <utility>
 #include <format>
 
+#include "../../benchmark.h"
+
 //cache-line 무효화로, 멀티스레드 성능이 싱글스레드 보다 낮아짐.
 //- 보통 cache-line 이 64 byte 단위이기 때문에,
 //- 64 byte 메모리 정렬로 해결 가능.
@@ -31,20 +33,6 @@ double st_num = 0;
 constexpr int64_t default_iteration_count = 100'000'000;
 constexpr double default_sum_value = 0.001;
 
-class ScopedTimer {
-public:
-	using clock = std::chrono::steady_clock;
-	using Func = std::function<void(double)>;
-
-	ScopedTimer(Func&& func) : m_func(func) {}
-	~ScopedTimer() {
-		double elaspedTime = std::chrono::duration<double>(clock::now() - m_stp).count();
-		m_func(elaspedTime);
-	}
-	clock::time_point m_stp{clock::now()};
-	std::function<void(double)> m_func;
-};
-
 void work1(int64_t n)
 {
 	for (int64_t i = 0; i < n; i++)
@@ -71,10 +59,6 @@ void work4(int64_t n)
 
 void MultiThreadWorkd(int64_t n)
 {
-	ScopedTimer timer([](double time) {
-		std::cout << std::format("multi-thread: {}: {}\n",
-		mt_num1 + mt_num2 + mt_num3 + mt_num4, time); });
-
 	std::thread t1(work1, n / 4);
 	std::thread t2(work2, n / 4);
 	std::thread t3(work3, n / 4);
@@ -87,16 +71,109 @@ void MultiThreadWorkd(int64_t n)
 
 void SingleThreadWork(int64_t n)
 {
-	ScopedTimer timer([](double time) {
-		std::cout << std::format("single-thread: {}: {}\n",
-		st_num, time); });
-
 	for (int64_t i = 0; i < n; i++)
 	{
 		st_num += default_sum_value;
 	}
 }
 
+#include <array>
+#include <iterator>
+#include <atomic>
+#include "ShardedCounter.h"
+// 쓰레드 수 x 배치 방식 별 counter 증가 처리량 (M ops/s).
+// - 쓰레드마다 같은 횟수만큼 증가 -> 선형으로 늘어나면 쓰레드 수에 비례해서 처리량이 커진다.
+namespace bench_sharded
+{
+	constexpr int kMaxThreads = 8;
+	constexpr int64_t kOpsPerThread = 5'000'000;
+
+	// 쓰레드마다 counter 하나씩이지만 붙어 있음 (mt_num1..4 와 같은 상황)
+	struct Packed
+	{
+		std::array<std::atomic<int64_t>, kMaxThreads> values{};
+		void Add(int t) { values[t].fetch_add(1, std::memory_order_relaxed); }
+	};
+
+	// 쓰레드마다 counter 하나씩, cache-line 단위로 떨어뜨림 (MYALIGN = alignas(64))
+	struct Padded
+	{
+		struct alignas(std::hardware_destructive_interference_size) Slot { std::atomic<int64_t> value{ 0 }; };
+		std::array<Slot, kMaxThreads> values{};
+		void Add(int t) { values[t].value.fetch_add(1, std::memory_order_relaxed); }
+	};
+
+	// counter 하나를 모두가 같이 씀 (true sharing)
+	struct Shared
+	{
+		std::atomic<int64_t> value{ 0 };
+		void Add(int) { value.fetch_add(1, std::memory_order_relaxed); }
+	};
+
+	struct Sharded
+	{
+		ShardedCounter<int64_t> counter;
+		void Add(int) { counter.Add(1); }
+	};
+
+	template <typename Counter>
+	void RunOnce(int numThreads)
+	{
+		auto counter = std::make_unique<Counter>();
+		std::vector<std::thread> threads;
+		for (int t = 0; t < numThreads; ++t) {
+			threads.emplace_back([&counter, t]() {
+				for (int64_t i = 0; i < kOpsPerThread; ++i)
+					counter->Add(t);
+			});
+		}
+		for (auto& t : threads) t.join();
+	}
+
+	template <typename Counter>
+	benchmark::Result Run(const char* name, int numThreads)
+	{
+		benchmark::Options options;
+		options.minRuns = 3;
+		options.maxRuns = 10;
+		return benchmark::Run(std::format("{}/{}", name, numThreads),
+			[numThreads]() { RunOnce<Counter>(numThreads); }, options);
+	}
+
+	// 실행 한 번 당 counter 값 / 증가 횟수. (counter 가 없으면 -)
+	std::string PerOp(const benchmark::Result& result, const char* counterName, int numThreads)
+	{
+		for (const auto& counter : result.counters) {
+			if (counter.name == counterName)
+				return std::format("{:.3f}", counter.median / (numThreads * kOpsPerThread));
+		}
+		return "-";
+	}
+
+	void test(std::vector<benchmark::Result>& results)
+	{
+		std::cout << __func__ << std::endl;
+		std::cout << std::format("{:>8} {:>10} {:>10} {:>10} {:>10}   (M ops/s | l1d_misses/op | hitm_loads/op)\n",
+			"threads", "packed", "padded", "shared", "sharded");
+		for (int numThreads = 1; numThreads <= kMaxThreads; numThreads *= 2) {
+			const benchmark::Result row[] = {
+				Run<Packed>("packed", numThreads), Run<Padded>("padded", numThreads),
+				Run<Shared>("shared", numThreads), Run<Sharded>("sharded", numThreads) };
+			results.insert(results.end(), std::begin(row), std::end(row));
+			auto mops = [numThreads](const benchmark::Result& r) { return numThreads * kOpsPerThread / r.medianSec / 1e6; };
+			std::cout << std::format("{:>8} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n", numThreads,
+				mops(row[0]), mops(row[1]), mops(row[2]), mops(row[3]));
+			if (row[0].counters.empty())
+				continue;
+			for (const char* counterName : { "l1d_misses", "hitm_loads" }) {
+				std::cout << std::format("{:>8} {:>10} {:>10} {:>10} {:>10}\n", "",
+					PerOp(row[0], counterName, numThreads), PerOp(row[1], counterName, numThreads),
+					PerOp(row[2], counterName, numThreads), PerOp(row[3], counterName, numThreads));
+			}
+		}
+	}
+}
+
 int main()
 {
 	std::cout << "cache-line: " << std::hardware_constructive_interference_size << std::endl;
@@ -110,6 +187,16 @@ int main()
 	std::cout << n << std::endl;
 	// std::cin >> n;
 
-	SingleThreadWork(n);
-	MultiThreadWorkd(n);
+	// 측정 결과는 07_FalseSharing.json 으로도 저장 (추세 비교용)
+	std::vector<benchmark::Result> results;
+	results.push_back(benchmark::Run("single-thread", [n]() { SingleThreadWork(n); }));
+	benchmark::Print(results.back());
+	results.push_back(benchmark::Run("multi-thread", [n]() { MultiThreadWorkd(n); }));
+	benchmark::Print(results.back());
+	std::cout << std::format("sum: single: {}, multi: {}\n", st_num, mt_num1 + mt_num2 + mt_num3 + mt_num4);
+
+	std::cout << std::format("{:-<{}}\n", "", 50);
+	bench_sharded::test(results);
+
+	benchmark::WriteJson(results, "07_FalseSharing.json");
 }
\ No newline at end of file
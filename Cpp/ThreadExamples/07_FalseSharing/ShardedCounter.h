@@ -0,0 +1,160 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace sharded_detail
+{
+	// 살아 있는 쓰레드마다 0 부터 빽빽한 번호를 준다.
+	// 쓰레드가 끝나면 번호를 돌려받아 다음 쓰레드가 다시 쓴다. (slot 개수가 쓰레드 생성 횟수만큼 늘지 않도록)
+	class ThreadSlotRegistry
+	{
+	public:
+		static size_t Acquire()
+		{
+			auto& registry = Instance();
+			std::lock_guard<std::mutex> lock(registry.m_mutex);
+			if (registry.m_free.empty())
+				return registry.m_next++;
+			// 가장 작은 번호부터 재사용
+			auto it = std::min_element(registry.m_free.begin(), registry.m_free.end());
+			const size_t index = *it;
+			*it = registry.m_free.back();
+			registry.m_free.pop_back();
+			return index;
+		}
+
+		static void Release(size_t index)
+		{
+			auto& registry = Instance();
+			std::lock_guard<std::mutex> lock(registry.m_mutex);
+			registry.m_free.push_back(index);
+		}
+
+	private:
+		static ThreadSlotRegistry& Instance()
+		{
+			static ThreadSlotRegistry registry;
+			return registry;
+		}
+
+		std::mutex m_mutex;
+		std::vector<size_t> m_free;
+		size_t m_next{ 0 };
+	};
+
+	struct ThreadSlotHolder
+	{
+		ThreadSlotHolder() : index(ThreadSlotRegistry::Acquire()) {}
+		~ThreadSlotHolder() { ThreadSlotRegistry::Release(index); }
+		const size_t index;
+	};
+
+	// 현재 쓰레드의 번호. 처음 호출할 때만 lock 을 잡는다.
+	inline size_t ThisThreadSlot()
+	{
+		thread_local ThreadSlotHolder holder;
+		return holder.index;
+	}
+
+	inline size_t DefaultNumSlots()
+	{
+		return std::max<size_t>(std::thread::hardware_concurrency(), 1) * 2;
+	}
+}
+
+// 쓰레드마다 따로 쓰는 값. slot 하나가 cache-line 하나를 차지하므로 서로 무효화하지 않는다.
+// - Local() 은 현재 쓰레드의 slot 을 돌려준다. (동시에 살아 있는 쓰레드 수가 numSlots 를 넘으면 예외)
+// - 다른 쓰레드의 slot 을 읽는 ForEach() 는 쓰는 쪽과 동기화된 뒤(join 등)에만 호출한다.
+template <typename T>
+class PerThread
+{
+public:
+	explicit PerThread(size_t numSlots = sharded_detail::DefaultNumSlots())
+		: m_numSlots(numSlots), m_slots(std::make_unique<Slot[]>(numSlots))
+	{
+		if (numSlots == 0) {
+			throw std::invalid_argument("PerThread: numSlots 는 0 보다 커야 함");
+		}
+	}
+
+	PerThread(const PerThread&) = delete;
+	PerThread& operator=(const PerThread&) = delete;
+
+	T& Local()
+	{
+		const size_t index = sharded_detail::ThisThreadSlot();
+		if (index >= m_numSlots) {
+			throw std::out_of_range("PerThread: slot 부족");
+		}
+		return m_slots[index].value;
+	}
+
+	size_t NumSlots() const { return m_numSlots; }
+
+	T& At(size_t index) { return m_slots[index].value; }
+	const T& At(size_t index) const { return m_slots[index].value; }
+
+	template <typename F>
+	void ForEach(F&& f)
+	{
+		for (size_t i = 0; i < m_numSlots; ++i) f(m_slots[i].value);
+	}
+
+	template <typename F>
+	void ForEach(F&& f) const
+	{
+		for (size_t i = 0; i < m_numSlots; ++i) f(m_slots[i].value);
+	}
+
+private:
+	struct alignas(std::hardware_destructive_interference_size) Slot
+	{
+		T value{};
+	};
+
+	size_t m_numSlots;
+	std::unique_ptr<Slot[]> m_slots;
+};
+
+// 여러 쓰레드가 자주 올리고 가끔 읽는 counter.
+// - Add() 는 자기 쓰레드 slot 에 relaxed fetch_add. (다른 쓰레드와 cache-line 을 공유하지 않음)
+// - Read() 는 모든 slot 을 더한다. 동시에 Add() 중이면 그 순간의 근사값.
+// - 쓰레드가 slot 수보다 많으면 slot 을 나눠 쓰지만, atomic 이므로 값은 정확하다.
+template <typename T>
+class ShardedCounter
+{
+public:
+	explicit ShardedCounter(size_t numSlots = sharded_detail::DefaultNumSlots()) : m_slots(numSlots) {}
+
+	void Add(T value)
+	{
+		const size_t index = sharded_detail::ThisThreadSlot() % m_slots.NumSlots();
+		m_slots.At(index).fetch_add(value, std::memory_order_relaxed);
+	}
+
+	ShardedCounter& operator+=(T value) { Add(value); return *this; }
+	ShardedCounter& operator++() { Add(T(1)); return *this; }
+
+	T Read() const
+	{
+		T sum{};
+		m_slots.ForEach([&sum](const std::atomic<T>& slot) { sum += slot.load(std::memory_order_relaxed); });
+		return sum;
+	}
+
+	void Reset()
+	{
+		m_slots.ForEach([](std::atomic<T>& slot) { slot.store(T{}, std::memory_order_relaxed); });
+	}
+
+private:
+	PerThread<std::atomic<T>> m_slots;
+};
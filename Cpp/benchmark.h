@@ -0,0 +1,360 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <cstring>
+#include <ctime>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+// 예제 공용 benchmark 도구.
+// - warmup 후 측정을 반복하고, 흔들림(MAD / median) 이 기준 이하가 되면 멈춘다.
+// - 결과는 median 과 MAD(median absolute deviation) 로 보고한다. (평균은 튀는 값에 약함)
+// - Linux 에서는 perf_event_open 으로 cycles / cache-miss / L1D 교체 / HITM 을 함께 센다.
+//   false sharing 같은 문제는 시간보다 이 값들의 차이로 더 분명하게 보인다.
+// - 결과 목록은 JSON 으로 저장해서 추세를 비교할 수 있다.
+namespace benchmark
+{
+	struct Options
+	{
+		int warmupRuns{ 1 };
+		int minRuns{ 5 };
+		int maxRuns{ 30 };
+		double targetRelativeMad{ 0.02 }; // MAD / median 이 이 값 이하면 안정된 것으로 본다.
+		double maxTotalSec{ 10.0 };       // 안정되지 않아도 이 시간이 지나면 멈춘다.
+		bool useCounters{ true };
+		// counter 를 셀 쓰레드(Linux tid). 비어 있으면 Run 을 부른 쓰레드와 측정 중 만든 쓰레드.
+		// 측정 전에 만들어 둔 쓰레드(thread pool 의 worker 등) 가 일하는 경우에 지정한다.
+		std::vector<int> threadIds;
+	};
+
+	struct CounterResult
+	{
+		std::string name;
+		double median;  // 한 번 실행 당 값의 median
+	};
+
+	struct Result
+	{
+		std::string name;
+		int runs{ 0 };
+		bool stable{ false };
+		double medianSec{ 0 };
+		double madSec{ 0 };
+		double minSec{ 0 };
+		double maxSec{ 0 };
+		std::vector<CounterResult> counters; // 지원하지 않는 환경에서는 비어 있음
+	};
+
+	namespace detail
+	{
+		inline double Median(std::vector<double> values)
+		{
+			if (values.empty())
+				return 0;
+			const size_t mid = values.size() / 2;
+			std::nth_element(values.begin(), values.begin() + mid, values.end());
+			double median = values[mid];
+			if (values.size() % 2 == 0) {
+				median = (median + *std::max_element(values.begin(), values.begin() + mid)) / 2;
+			}
+			return median;
+		}
+
+		inline double MedianAbsoluteDeviation(const std::vector<double>& values, double median)
+		{
+			std::vector<double> deviations;
+			deviations.reserve(values.size());
+			for (double v : values) deviations.push_back(std::abs(v - median));
+			return Median(std::move(deviations));
+		}
+
+		inline std::string EscapeJson(const std::string& text)
+		{
+			std::string escaped;
+			for (char c : text) {
+				switch (c) {
+				case '"': escaped += "\\\""; break;
+				case '\\': escaped += "\\\\"; break;
+				case '\n': escaped += "\\n"; break;
+				case '\t': escaped += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+						escaped += std::format("\\u{:04x}", static_cast<int>(c));
+					else
+						escaped += c;
+				}
+			}
+			return escaped;
+		}
+
+		inline std::string FormatSeconds(double sec)
+		{
+			if (sec >= 1.0) return std::format("{:.3f} s", sec);
+			if (sec >= 1e-3) return std::format("{:.3f} ms", sec * 1e3);
+			if (sec >= 1e-6) return std::format("{:.3f} us", sec * 1e6);
+			return std::format("{:.1f} ns", sec * 1e9);
+		}
+	}
+
+	// 하드웨어 counter 묶음. 측정 구간 동안 만들어진 쓰레드까지 포함해서 센다. (inherit)
+	// threadIds 를 주면 현재 쓰레드 대신 그 쓰레드들에서 각각 세고 합친다.
+	// Linux 가 아니거나 권한이 없으면(perf_event_paranoid) 열리는 counter 가 없을 뿐 오류는 아니다.
+	class PerfCounters
+	{
+	public:
+		explicit PerfCounters(const std::vector<int>& threadIds = {})
+		{
+#if defined(__linux__)
+			m_threadIds = threadIds.empty() ? std::vector<int>{ 0 } : threadIds;
+			Open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+			Open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+			Open("cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+			// L1D 읽기 miss (Intel 에서는 L1D.REPLACEMENT 와 거의 같은 값)
+			Open("l1d_misses", PERF_TYPE_HW_CACHE,
+				PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+			// 다른 core 의 수정된 cache-line 을 가져온 load (HITM). 모델마다 번호가 달라 Intel 만.
+			// MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM (event 0xD2, umask 0x04: Skylake ~ Ice Lake)
+			if (IsIntel())
+				Open("hitm_loads", PERF_TYPE_RAW, 0x04D2);
+#else
+			(void)threadIds;
+#endif
+		}
+
+		~PerfCounters()
+		{
+#if defined(__linux__)
+			for (auto& counter : m_counters) {
+				for (int fd : counter.fds) close(fd);
+			}
+#endif
+		}
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters& operator=(const PerfCounters&) = delete;
+
+		bool Available() const { return !m_counters.empty(); }
+
+		void Start()
+		{
+#if defined(__linux__)
+			for (auto& counter : m_counters) {
+				for (int fd : counter.fds) {
+					ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+					ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+				}
+			}
+#endif
+		}
+
+		// 시작 이후의 값. (counter 가 번갈아 측정(multiplexing)되었으면 비율로 보정)
+		std::vector<std::pair<std::string, double>> Stop()
+		{
+			std::vector<std::pair<std::string, double>> values;
+#if defined(__linux__)
+			for (auto& counter : m_counters) {
+				for (int fd : counter.fds) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			}
+			for (auto& counter : m_counters) {
+				double total = 0;
+				for (int fd : counter.fds) {
+					uint64_t data[3] = {}; // value, time_enabled, time_running
+					if (read(fd, data, sizeof(data)) != sizeof(data))
+						data[0] = 0;
+					double value = static_cast<double>(data[0]);
+					if (data[2] != 0 && data[2] < data[1])
+						value *= static_cast<double>(data[1]) / data[2];
+					total += value;
+				}
+				values.emplace_back(counter.name, total);
+			}
+#endif
+			return values;
+		}
+
+	private:
+#if defined(__linux__)
+		void Open(const char* name, uint32_t type, uint64_t config)
+		{
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = type;
+			attr.config = config;
+			attr.disabled = 1;
+			attr.inherit = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			// 쓰레드 하나라도 열리지 않으면 그 counter 는 뺀다. (일부 쓰레드만 센 값은 비교할 수 없음)
+			Counter counter{ name, {} };
+			for (int tid : m_threadIds) {
+				const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+				if (fd < 0) {
+					for (int opened : counter.fds) close(opened);
+					return;
+				}
+				counter.fds.push_back(fd);
+			}
+			m_counters.push_back(std::move(counter));
+		}
+
+		static bool IsIntel()
+		{
+			std::ifstream cpuinfo("/proc/cpuinfo");
+			std::string line;
+			while (std::getline(cpuinfo, line)) {
+				if (line.rfind("vendor_id", 0) == 0)
+					return line.find("GenuineIntel") != std::string::npos;
+			}
+			return false;
+		}
+#endif
+
+		struct Counter
+		{
+			std::string name;
+			std::vector<int> fds; // 쓰레드마다 하나
+		};
+		std::vector<Counter> m_counters;
+#if defined(__linux__)
+		std::vector<int> m_threadIds; // 0: 현재 쓰레드
+#endif
+	};
+
+	// 프로세스의 모든 쓰레드가 지금까지 사용한 CPU 시간(user + kernel). 지원하지 않으면 0.
+	// 구간 전후의 차이를 벽시계 시간으로 나누면 평균 몇 개의 core 를 태웠는지 알 수 있다. (spin 비용 등)
+	inline double ProcessCpuSeconds()
+	{
+#if defined(__linux__)
+		timespec ts{};
+		if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+			return 0;
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+#elif defined(_WIN32)
+		FILETIME creation, exit, kernel, user;
+		if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+			return 0;
+		auto toSeconds = [](const FILETIME& ft) {
+			return ((static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) * 100e-9; // 100ns 단위
+		};
+		return toSeconds(kernel) + toSeconds(user);
+#else
+		return 0;
+#endif
+	}
+
+	// f 를 warmup 후 반복 측정한다.
+	template <typename F>
+	Result Run(const std::string& name, F&& f, const Options& options = {})
+	{
+		using clock = std::chrono::steady_clock;
+
+		for (int i = 0; i < options.warmupRuns; ++i) f();
+
+		std::unique_ptr<PerfCounters> counters;
+		if (options.useCounters)
+			counters = std::make_unique<PerfCounters>(options.threadIds);
+
+		Result result;
+		result.name = name;
+		std::vector<double> times;
+		std::vector<std::pair<std::string, std::vector<double>>> counterValues;
+
+		const auto begin = clock::now();
+		while (true) {
+			if (counters) counters->Start();
+			const auto stp = clock::now();
+			f();
+			const double elapsed = std::chrono::duration<double>(clock::now() - stp).count();
+			if (counters) {
+				auto values = counters->Stop();
+				if (counterValues.empty()) {
+					for (auto& [counterName, value] : values) counterValues.push_back({ counterName, {} });
+				}
+				for (size_t i = 0; i < values.size() && i < counterValues.size(); ++i)
+					counterValues[i].second.push_back(values[i].second);
+			}
+			times.push_back(elapsed);
+
+			const int runs = static_cast<int>(times.size());
+			if (runs < options.minRuns)
+				continue;
+			result.medianSec = detail::Median(times);
+			result.madSec = detail::MedianAbsoluteDeviation(times, result.medianSec);
+			result.stable = result.madSec <= options.targetRelativeMad * result.medianSec;
+			if (result.stable || runs >= options.maxRuns ||
+				std::chrono::duration<double>(clock::now() - begin).count() >= options.maxTotalSec)
+				break;
+		}
+
+		result.runs = static_cast<int>(times.size());
+		result.minSec = *std::min_element(times.begin(), times.end());
+		result.maxSec = *std::max_element(times.begin(), times.end());
+		for (auto& [counterName, values] : counterValues)
+			result.counters.push_back({ counterName, detail::Median(values) });
+		return result;
+	}
+
+	inline void Print(const Result& result, std::ostream& os = std::cout)
+	{
+		os << std::format("{}: {} (MAD {}, runs {}{})", result.name,
+			detail::FormatSeconds(result.medianSec), detail::FormatSeconds(result.madSec),
+			result.runs, result.stable ? "" : ", unstable");
+		for (const auto& counter : result.counters)
+			os << std::format(", {}: {:.0f}", counter.name, counter.median);
+		os << '\n';
+	}
+
+	inline void WriteJson(const std::vector<Result>& results, std::ostream& os)
+	{
+		os << "{\n  \"benchmarks\": [";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result& r = results[i];
+			os << (i == 0 ? "\n" : ",\n");
+			os << std::format("    {{\"name\": \"{}\", \"runs\": {}, \"stable\": {}, "
+				"\"median_ns\": {:.1f}, \"mad_ns\": {:.1f}, \"min_ns\": {:.1f}, \"max_ns\": {:.1f}, \"counters\": {{",
+				detail::EscapeJson(r.name), r.runs, r.stable ? "true" : "false",
+				r.medianSec * 1e9, r.madSec * 1e9, r.minSec * 1e9, r.maxSec * 1e9);
+			for (size_t j = 0; j < r.counters.size(); ++j) {
+				os << std::format("{}\"{}\": {:.0f}", j == 0 ? "" : ", ",
+					detail::EscapeJson(r.counters[j].name), r.counters[j].median);
+			}
+			os << "}}";
+		}
+		os << "\n  ]\n}\n";
+	}
+
+	inline bool WriteJson(const std::vector<Result>& results, const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file)
+			return false;
+		WriteJson(results, file);
+		return static_cast<bool>(file);
+	}
+}